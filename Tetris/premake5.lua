@@ -66,11 +66,86 @@ workspace "Tetris"
             "IOKit.framework"
         }
 
+        -- Fonts are baked before res is copied next to the executable
+        dependson
+        {
+            "FontBaker"
+        }
+
+        prebuildcommands
+        {
+            "\"%{wks.location}/bin/" .. outputdir .. "/FontBaker/FontBaker\" %{wks.location}/res/fonts/tahoma.fnt %{wks.location}/res/fonts/tahoma.font --sdf"
+        }
+
         postbuildcommands 
         {
             "{COPY} %{wks.location}/res %{cfg.targetdir}"
         }
 
+        filter "configurations:Debug"
+		    runtime "Debug"
+		    symbols "on"
+		    defines { "TETRIS_PROFILE" }
+
+	    filter "configurations:Release"
+		    runtime "Release"
+		    optimize "on"
+
+    project "TetrisBench"
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++1z"
+
+        targetdir ("%{wks.location}/bin/" .. outputdir .. "/%{prj.name}")
+        objdir ("%{wks.location}/bin-int/" .. outputdir .. "/%{prj.name}")
+
+        files
+        {
+            "src/Tetris/Core/**.h",
+            "src/Tetris/Core/**.cpp",
+            "src/TetrisBench/**.h",
+            "src/TetrisBench/**.cpp"
+        }
+
+        includedirs
+        {
+            "src/Tetris"
+        }
+
+        filter "system:linux"
+            links { "pthread" }
+
+        filter "configurations:Debug"
+		    runtime "Debug"
+		    symbols "on"
+
+	    filter "configurations:Release"
+		    runtime "Release"
+		    optimize "on"
+
+    project "FontBaker"
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++1z"
+
+        targetdir ("%{wks.location}/bin/" .. outputdir .. "/%{prj.name}")
+        objdir ("%{wks.location}/bin-int/" .. outputdir .. "/%{prj.name}")
+
+        files
+        {
+            "src/FontBaker/**.h",
+            "src/FontBaker/**.cpp",
+            "src/Tetris/FontFile.h",
+            "src/vendor/stb_image/**.cpp",
+            "src/vendor/stb_image/**.h"
+        }
+
+        includedirs
+        {
+            "src/Tetris",
+            "%{IncludeDir.stb_image}"
+        }
+
         filter "configurations:Debug"
 		    runtime "Debug"
 		    symbols "on"
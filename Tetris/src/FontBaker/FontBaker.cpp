@@ -0,0 +1,468 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <algorithm>
+#include <cmath>
+
+#include "stb_image.h"
+
+#include "FontFile.h"
+
+// Converts a BMFont text font (.fnt plus its single PNG page) into the binary font the game maps at startup
+//
+//  FontBaker <input.fnt> <output.font> [--rgba] [--sdf] [--sdf-range pixels] [--sdf-downscale factor]
+//
+// Atlases with only white texels keep just the coverage channel unless --rgba is given. --sdf replaces the coverage
+// by a signed distance field of the glyphs, repacked into a smaller single channel atlas that renders sharp at any size
+
+struct BMFont
+{
+    uint32_t TextureWidth = 0;
+    uint32_t TextureHeight = 0;
+    uint32_t PageCount = 0;
+    std::string PageFile;
+    std::vector<FontFileGlyph> Glyphs;
+};
+
+// Value of key=value tokens, quotes are stripped
+static std::string GetValue(const std::string& token)
+{
+    std::string value = token.substr(token.find('=') + 1);
+
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+        value = value.substr(1, value.size() - 2);
+
+    return value;
+}
+
+static bool ParseFnt(const std::string& path, BMFont& outFont)
+{
+    std::ifstream fileStream(path);
+    if (!fileStream.is_open())
+    {
+        std::cout << "Failed to open " << path << "!" << std::endl;
+        return false;
+    }
+
+    std::string line;
+    std::stringstream stringStream;
+    std::string tag;
+    std::string token;
+
+    while (std::getline(fileStream, line))
+    {
+        stringStream.clear();
+        stringStream.str(line);
+        stringStream >> tag;
+
+        if (tag == "common")
+        {
+            while (stringStream >> token)
+            {
+                if (token.compare(0, 7, "scaleW=") == 0)
+                    outFont.TextureWidth = std::stoul(GetValue(token));
+                else if (token.compare(0, 7, "scaleH=") == 0)
+                    outFont.TextureHeight = std::stoul(GetValue(token));
+                else if (token.compare(0, 6, "pages=") == 0)
+                    outFont.PageCount = std::stoul(GetValue(token));
+            }
+        }
+        else if (tag == "page")
+        {
+            while (stringStream >> token)
+            {
+                if (token.compare(0, 5, "file=") == 0)
+                    outFont.PageFile = GetValue(token);
+            }
+        }
+        else if (tag == "char")
+        {
+            FontFileGlyph glyph = {};
+
+            while (stringStream >> token)
+            {
+                std::string key = token.substr(0, token.find('='));
+
+                if (key == "id")                glyph.CharID = std::stoul(GetValue(token));
+                else if (key == "x")            glyph.X = std::stoi(GetValue(token));
+                else if (key == "y")            glyph.Y = std::stoi(GetValue(token));
+                else if (key == "width")        glyph.Width = std::stoi(GetValue(token));
+                else if (key == "height")       glyph.Height = std::stoi(GetValue(token));
+                else if (key == "xoffset")      glyph.XOffset = std::stoi(GetValue(token));
+                else if (key == "yoffset")      glyph.YOffset = std::stoi(GetValue(token));
+                else if (key == "xadvance")     glyph.XAdvance = std::stoi(GetValue(token));
+            }
+
+            outFont.Glyphs.push_back(glyph);
+        }
+    }
+
+    if (outFont.TextureWidth == 0 || outFont.TextureHeight == 0 || outFont.PageFile.empty())
+    {
+        std::cout << path << " has no common or page line!" << std::endl;
+        return false;
+    }
+
+    if (outFont.PageCount != 1)
+    {
+        std::cout << path << " has " << outFont.PageCount << " pages, only single page fonts are supported!" << std::endl;
+        return false;
+    }
+
+    // Same normalization as the runtime parser, v grows upwards because the texels are stored bottom row first
+    float width = outFont.TextureWidth;
+    float height = outFont.TextureHeight;
+
+    for (FontFileGlyph& glyph : outFont.Glyphs)
+    {
+        glyph.U0 = glyph.X / width;
+        glyph.V0 = (height - glyph.Y) / height;
+        glyph.U1 = (glyph.X + glyph.Width) / width;
+        glyph.V1 = (height - glyph.Y - glyph.Height) / height;
+    }
+
+    return true;
+}
+
+// Squared distance transform of one row or column (Felzenszwalb and Huttenlocher), f holds 0 at the feature pixels
+// and a large value elsewhere
+static void DistanceTransform(const float* f, float* d, int count, int* vertices, float* boundaries)
+{
+    int k = 0;
+    vertices[0] = 0;
+    boundaries[0] = -1e20f;
+    boundaries[1] = 1e20f;
+
+    for (int q = 1; q < count; q++)
+    {
+        float s = ((f[q] + q * q) - (f[vertices[k]] + vertices[k] * vertices[k])) / (2.0f * q - 2.0f * vertices[k]);
+        while (s <= boundaries[k])
+        {
+            k--;
+            s = ((f[q] + q * q) - (f[vertices[k]] + vertices[k] * vertices[k])) / (2.0f * q - 2.0f * vertices[k]);
+        }
+
+        k++;
+        vertices[k] = q;
+        boundaries[k] = s;
+        boundaries[k + 1] = 1e20f;
+    }
+
+    k = 0;
+    for (int q = 0; q < count; q++)
+    {
+        while (boundaries[k + 1] < q)
+            k++;
+
+        d[q] = (q - vertices[k]) * (q - vertices[k]) + f[vertices[k]];
+    }
+}
+
+// Squared distance of every pixel to the nearest pixel where feature is set
+static std::vector<float> DistanceTransform(const std::vector<bool>& feature, int width, int height)
+{
+    int size = std::max(width, height);
+    std::vector<float> f(size), d(size), boundaries(size + 1);
+    std::vector<int> vertices(size);
+
+    std::vector<float> distances(width * height);
+    for (int i = 0; i < width * height; i++)
+        distances[i] = feature[i] ? 0.0f : 1e20f;
+
+    for (int x = 0; x < width; x++)
+    {
+        for (int y = 0; y < height; y++)
+            f[y] = distances[y * width + x];
+
+        DistanceTransform(f.data(), d.data(), height, vertices.data(), boundaries.data());
+
+        for (int y = 0; y < height; y++)
+            distances[y * width + x] = d[y];
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        DistanceTransform(&distances[y * width], d.data(), width, vertices.data(), boundaries.data());
+        std::copy(d.begin(), d.begin() + width, distances.begin() + y * width);
+    }
+
+    return distances;
+}
+
+// Replaces the glyph bitmaps by distance fields, every glyph gets range pixels of margin on each side and is sampled
+// every downscale pixels. The cells are packed into rows of a new atlas, the glyph table is rewritten to match.
+// pixels is the RGBA page with the bottom row first
+static void BakeDistanceField(BMFont& font, const unsigned char* pixels, uint32_t range, uint32_t downscale, std::vector<uint8_t>& outTexels)
+{
+    struct Cell
+    {
+        uint32_t Glyph;
+        uint32_t Width, Height;     // texels
+        std::vector<uint8_t> Texels;
+    };
+
+    std::vector<Cell> cells;
+
+    for (uint32_t i = 0; i < font.Glyphs.size(); i++)
+    {
+        FontFileGlyph& glyph = font.Glyphs[i];
+        if (glyph.Width <= 0 || glyph.Height <= 0)
+            continue;
+
+        // Rounded up so that every texel covers whole font pixels
+        int width = (glyph.Width + 2 * range + downscale - 1) / downscale * downscale;
+        int height = (glyph.Height + 2 * range + downscale - 1) / downscale * downscale;
+
+        // Rows from the top, inside where the coverage reaches half
+        std::vector<bool> inside(width * height, false);
+        std::vector<bool> outside(width * height, true);
+
+        for (int y = 0; y < glyph.Height; y++)
+        {
+            for (int x = 0; x < glyph.Width; x++)
+            {
+                uint64_t row = font.TextureHeight - 1 - (glyph.Y + y);
+                bool covered = pixels[(row * font.TextureWidth + glyph.X + x) * 4 + 3] >= 128;
+
+                inside[(y + range) * width + x + range] = covered;
+                outside[(y + range) * width + x + range] = !covered;
+            }
+        }
+
+        std::vector<float> distanceToInside = DistanceTransform(inside, width, height);
+        std::vector<float> distanceToOutside = DistanceTransform(outside, width, height);
+
+        Cell cell;
+        cell.Glyph = i;
+        cell.Width = width / downscale;
+        cell.Height = height / downscale;
+        cell.Texels.resize(cell.Width * cell.Height);
+
+        for (uint32_t cellY = 0; cellY < cell.Height; cellY++)
+        {
+            for (uint32_t cellX = 0; cellX < cell.Width; cellX++)
+            {
+                // Mean over the font pixels of the texel, the pixel centers lie half a pixel from the outline
+                float distance = 0.0f;
+
+                for (uint32_t y = cellY * downscale; y < (cellY + 1) * downscale; y++)
+                {
+                    for (uint32_t x = cellX * downscale; x < (cellX + 1) * downscale; x++)
+                    {
+                        uint32_t pixel = y * width + x;
+                        distance += inside[pixel] ? std::sqrt(distanceToOutside[pixel]) - 0.5f : 0.5f - std::sqrt(distanceToInside[pixel]);
+                    }
+                }
+
+                distance /= downscale * downscale;
+
+                float value = std::min(std::max(0.5f + distance / (2.0f * range), 0.0f), 1.0f);
+                cell.Texels[cellY * cell.Width + cellX] = (uint8_t)std::lround(value * 255.0f);
+            }
+        }
+
+        glyph.Width = width;
+        glyph.Height = height;
+        glyph.XOffset -= range;
+        glyph.YOffset -= range;
+
+        cells.push_back(std::move(cell));
+    }
+
+    // Tallest first into rows, one empty texel between cells keeps linear filtering from reaching the neighbours
+    std::sort(cells.begin(), cells.end(), [](const Cell& a, const Cell& b) { return a.Height > b.Height; });
+
+    uint32_t atlasWidth = 64;
+    uint32_t atlasHeight = 0;
+    std::vector<uint32_t> cellX(cells.size()), cellY(cells.size());
+
+    while (true)
+    {
+        uint32_t x = 1, y = 1, rowHeight = 0;
+        bool fits = true;
+
+        for (uint32_t i = 0; i < cells.size() && fits; i++)
+        {
+            if (x + cells[i].Width + 1 > atlasWidth)
+            {
+                x = 1;
+                y += rowHeight + 1;
+                rowHeight = 0;
+            }
+
+            fits = x + cells[i].Width + 1 <= atlasWidth;
+            cellX[i] = x;
+            cellY[i] = y;
+            x += cells[i].Width + 1;
+            rowHeight = std::max(rowHeight, cells[i].Height);
+        }
+
+        atlasHeight = 1;
+        while (atlasHeight < y + rowHeight + 1)
+            atlasHeight *= 2;
+
+        // Square or one step wider than high
+        if (fits && atlasHeight <= atlasWidth)
+            break;
+
+        atlasWidth *= 2;
+    }
+
+    outTexels.assign((uint64_t)atlasWidth * atlasHeight, 0);
+
+    for (uint32_t i = 0; i < cells.size(); i++)
+    {
+        const Cell& cell = cells[i];
+        FontFileGlyph& glyph = font.Glyphs[cell.Glyph];
+
+        // Stored bottom row first like every baked atlas
+        for (uint32_t y = 0; y < cell.Height; y++)
+        {
+            uint64_t row = atlasHeight - 1 - (cellY[i] + y);
+            std::copy(&cell.Texels[y * cell.Width], &cell.Texels[y * cell.Width] + cell.Width, &outTexels[row * atlasWidth + cellX[i]]);
+        }
+
+        glyph.X = cellX[i];
+        glyph.Y = cellY[i];
+        glyph.U0 = (float)cellX[i] / atlasWidth;
+        glyph.V0 = (float)(atlasHeight - cellY[i]) / atlasHeight;
+        glyph.U1 = (float)(cellX[i] + cell.Width) / atlasWidth;
+        glyph.V1 = (float)(atlasHeight - cellY[i] - cell.Height) / atlasHeight;
+    }
+
+    font.TextureWidth = atlasWidth;
+    font.TextureHeight = atlasHeight;
+}
+
+int main(int argc, char** argv)
+{
+    std::string inputPath;
+    std::string outputPath;
+    bool forceRGBA = false;
+    bool distanceField = false;
+    uint32_t distanceRange = 8;
+    uint32_t distanceDownscale = 2;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+
+        if (argument == "--rgba")
+            forceRGBA = true;
+        else if (argument == "--sdf")
+            distanceField = true;
+        else if (argument == "--sdf-range" && i + 1 < argc)
+            distanceRange = std::max(std::stoi(argv[++i]), 1);
+        else if (argument == "--sdf-downscale" && i + 1 < argc)
+            distanceDownscale = std::max(std::stoi(argv[++i]), 1);
+        else if (inputPath.empty())
+            inputPath = argument;
+        else if (outputPath.empty())
+            outputPath = argument;
+    }
+
+    if (inputPath.empty() || outputPath.empty())
+    {
+        std::cout << "Usage: FontBaker <input.fnt> <output.font> [--rgba] [--sdf] [--sdf-range pixels] [--sdf-downscale factor]" << std::endl;
+        return -1;
+    }
+
+    BMFont font;
+    if (!ParseFnt(inputPath, font))
+        return -1;
+
+    // The page file name is relative to the .fnt
+    size_t separator = inputPath.find_last_of("/\\");
+    std::string pagePath = (separator == std::string::npos ? "" : inputPath.substr(0, separator + 1)) + font.PageFile;
+
+    stbi_set_flip_vertically_on_load(1);
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(pagePath.c_str(), &width, &height, &channels, 4);
+
+    if (!pixels)
+    {
+        std::cout << "Failed to load " << pagePath << "!" << std::endl;
+        return -1;
+    }
+
+    if ((uint32_t)width != font.TextureWidth || (uint32_t)height != font.TextureHeight)
+    {
+        std::cout << pagePath << " is " << width << "x" << height << " but the font expects "
+                  << font.TextureWidth << "x" << font.TextureHeight << "!" << std::endl;
+        stbi_image_free(pixels);
+        return -1;
+    }
+
+    uint64_t pixelCount = (uint64_t)width * height;
+
+    // Glyphs rendered white only differ in coverage, the color channels carry no information
+    bool whiteOnly = !forceRGBA;
+    for (uint64_t i = 0; i < pixelCount && whiteOnly; i++)
+    {
+        const unsigned char* pixel = &pixels[i * 4];
+        whiteOnly = pixel[3] == 0 || (pixel[0] == 255 && pixel[1] == 255 && pixel[2] == 255);
+    }
+
+    std::vector<uint8_t> texels;
+
+    if (distanceField)
+    {
+        // Only the outline survives, colored glyphs are tinted by the vertex color instead
+        BakeDistanceField(font, pixels, distanceRange, distanceDownscale, texels);
+        whiteOnly = true;
+    }
+    else if (whiteOnly)
+    {
+        texels.resize(pixelCount);
+        for (uint64_t i = 0; i < pixelCount; i++)
+            texels[i] = pixels[i * 4 + 3];
+    }
+    else
+    {
+        texels.assign(pixels, pixels + pixelCount * 4);
+    }
+
+    stbi_image_free(pixels);
+
+    FontFileHeader header = {};
+    header.Magic = FontFileMagic;
+    header.Version = FontFileVersion;
+    header.GlyphCount = font.Glyphs.size();
+    header.TextureWidth = font.TextureWidth;
+    header.TextureHeight = font.TextureHeight;
+    header.ChannelCount = whiteOnly ? 1 : 4;
+    header.Flags = distanceField ? FontFileFlagDistanceField : 0;
+    header.DistanceRange = distanceField ? distanceRange : 0.0f;
+    header.GlyphOffset = sizeof(FontFileHeader);
+    header.TexelOffset = (header.GlyphOffset + header.GlyphCount * sizeof(FontFileGlyph) + FontFileTexelAlignment - 1) / FontFileTexelAlignment * FontFileTexelAlignment;
+    header.TexelSize = texels.size();
+
+    std::ofstream outputStream(outputPath, std::ios::binary);
+    if (!outputStream.is_open())
+    {
+        std::cout << "Failed to open " << outputPath << "!" << std::endl;
+        return -1;
+    }
+
+    const char padding[FontFileTexelAlignment] = {};
+    uint64_t paddingSize = header.TexelOffset - header.GlyphOffset - header.GlyphCount * sizeof(FontFileGlyph);
+
+    outputStream.write((const char*)&header, sizeof(header));
+    outputStream.write((const char*)font.Glyphs.data(), font.Glyphs.size() * sizeof(FontFileGlyph));
+    outputStream.write(padding, paddingSize);
+    outputStream.write((const char*)texels.data(), texels.size());
+
+    if (!outputStream)
+    {
+        std::cout << "Failed to write " << outputPath << "!" << std::endl;
+        return -1;
+    }
+
+    std::cout << "baked " << outputPath << " glyphs=" << header.GlyphCount << " texture=" << header.TextureWidth << "x" << header.TextureHeight
+              << " channels=" << header.ChannelCount << (distanceField ? " sdf" : "") << " bytes=" << header.TexelOffset + header.TexelSize << std::endl;
+
+    return 0;
+}
@@ -2,34 +2,48 @@
 #include <chrono>
 #include <stdlib.h>
 #include <time.h>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <vector>
 
 #include <GLFW/glfw3.h>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "AssetLoader.h"
+#include "BatchRenderer.h"
+#include "FrameScheduler.h"
+#include "GLState.h"
+#include "InputQueue.h"
+#include "Profiler.h"
+#include "ShaderManager.h"
 #include "TextRenderer.h"
-
-static uint32_t s_ScreenWidth = 640;
-static uint32_t s_ScreenHeight = 480;
-static float s_QuadSize = 0.0f;
+#include "Core/Board.h"
+#include "Core/Bot.h"
+#include "Core/Game.h"
+#include "Core/Piece.h"
+#include "Core/Random.h"
+#include "Core/Replay.h"
+#include "Core/Tetromino.h"
 
 class Playfield
 {
 public:
-    Playfield(uint32_t horizontalQuadCount, uint32_t verticalQuadCount)
-        : m_VertexBufferID(0), m_IndexBufferID(0), m_VertexArrayID(0), m_BorderDistance(0), m_HorizontalQuadCount(horizontalQuadCount), m_VerticalQuadCount(verticalQuadCount)
+    Playfield(uint32_t screenWidth, uint32_t screenHeight, uint32_t horizontalQuadCount, uint32_t verticalQuadCount)
+        : m_VertexBufferID(0), m_IndexBufferID(0), m_VertexArrayID(0), m_ScreenWidth(screenWidth), m_ScreenHeight(screenHeight), m_QuadSize(0.0f), m_BorderDistance(0),
+          m_HorizontalQuadCount(horizontalQuadCount), m_VerticalQuadCount(verticalQuadCount)
     {
-        s_QuadSize = s_ScreenHeight / verticalQuadCount;
-        m_BorderDistance = (s_ScreenWidth - horizontalQuadCount * s_QuadSize) / 2;
+        m_QuadSize = m_ScreenHeight / verticalQuadCount;
+        m_BorderDistance = (m_ScreenWidth - horizontalQuadCount * m_QuadSize) / 2;
 
 
         float vertices[] = {
             (float)m_BorderDistance, 0.0f,
-            (float)m_BorderDistance, (float)s_ScreenHeight,
-            (float)s_ScreenWidth - (float)m_BorderDistance, 0.0f,
-            (float)s_ScreenWidth - (float)m_BorderDistance, (float)s_ScreenHeight
+            (float)m_BorderDistance, (float)m_ScreenHeight,
+            (float)m_ScreenWidth - (float)m_BorderDistance, 0.0f,
+            (float)m_ScreenWidth - (float)m_BorderDistance, (float)m_ScreenHeight
         };
 
         uint32_t indices[] = {
@@ -47,14 +61,20 @@ public:
 
         glGenVertexArrays(1, &m_VertexArrayID);
         glBindVertexArray(m_VertexArrayID);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+        glBindVertexArray(0);
     }
 public:
     uint32_t GetVertexBufferID() const { return m_VertexBufferID; }
     uint32_t GetIndexBufferID() const { return m_IndexBufferID; }
     uint32_t GetVertexArrayID() const { return m_VertexArrayID; }
 
+    uint32_t GetScreenWidth() const { return m_ScreenWidth; }
+    uint32_t GetScreenHeight() const { return m_ScreenHeight; }
+    float GetQuadSize() const { return m_QuadSize; }
+
     uint32_t GetBorderDistance() const { return m_BorderDistance; }
     uint32_t GetHorizontalQuadCount() const { return m_HorizontalQuadCount; }
     uint32_t GetVerticalQuadCount() const { return m_VerticalQuadCount; }
@@ -63,6 +83,10 @@ private:
     uint32_t m_IndexBufferID;
     uint32_t m_VertexArrayID;
 
+    uint32_t m_ScreenWidth;
+    uint32_t m_ScreenHeight;
+    float m_QuadSize;
+
     uint32_t m_BorderDistance;
     uint32_t m_HorizontalQuadCount;
     uint32_t m_VerticalQuadCount;
@@ -71,115 +95,165 @@ private:
 class PieceTable
 {
 public:
-    PieceTable(const Playfield& playfield)
-        : m_VertexBufferID(0), m_IndexBufferID(0), m_VertexArrayID(0), m_PieceTable(new uint32_t[playfield.GetHorizontalQuadCount() * playfield.GetVerticalQuadCount()])
+    enum class RenderMode
     {
+        // 4 vertices per cell, every vertex carries its position and a float color ID
+        Quads,
+        // One static unit quad drawn once per cell, the only per cell data is an 8 bit color ID
+        Instanced,
+        // One quad covering the whole board, the cells are an R8UI texture looked up in the fragment shader
+        Texture,
+        // Nothing on the GPU, Renderer::SubmitPieceTable hands the filled cells to the 2D batch every frame
+        Batched
+    };
 
-        for (uint32_t i = 0; i < playfield.GetHorizontalQuadCount() * playfield.GetVerticalQuadCount(); i++)
+    // RGBA of every color ID
+    static constexpr uint8_t Palette[] = {
+        0, 0, 0, 0,
+        0, 0, 255, 255,
+        255, 166, 0, 255,
+        255, 255, 0, 255,
+        0, 255, 0, 255,
+        128, 0, 128, 255,
+        255, 0, 0, 255,
+        0, 255, 255, 255
+    };
+
+    // Summed over the uploads since the last reset, the largest single upload shows whether line clears stay flat
+    struct UploadStats
+    {
+        uint32_t Bytes = 0;
+        uint32_t Calls = 0;
+        uint32_t MaxBytes = 0;
+    };
+
+public:
+    PieceTable(const Playfield& playfield, RenderMode renderMode)
+        : m_VertexBufferID(0), m_IndexBufferID(0), m_VertexArrayID(0), m_InstanceBufferID(0), m_CellTextureID(0), m_PaletteTextureID(0), m_RenderMode(renderMode),
+          m_QuadCount(playfield.GetHorizontalQuadCount() * playfield.GetVerticalQuadCount()), m_ColumnCount(playfield.GetHorizontalQuadCount()),
+          m_QuadSize(playfield.GetQuadSize()), m_Origin((float)playfield.GetBorderDistance(), (float)playfield.GetScreenHeight()), m_PieceTable(m_QuadCount, 0), m_DirtyBegin(m_QuadCount), m_DirtyEnd(0)
+    {
+        switch (m_RenderMode)
         {
-            m_PieceTable[i] = 0;
+        case RenderMode::Quads:         CreateQuadBuffers(playfield); break;
+        case RenderMode::Instanced:     CreateInstancedBuffers(); break;
+        case RenderMode::Texture:       CreateTextures(playfield); break;
+        case RenderMode::Batched:       break;
         }
+    }
 
-        float vertices[playfield.GetVerticalQuadCount() * playfield.GetHorizontalQuadCount() * 4 * 3];
-        uint32_t indices[playfield.GetVerticalQuadCount() * playfield.GetHorizontalQuadCount() * 6];
+    ~PieceTable()
+    {
+        glDeleteBuffers(1, &m_VertexBufferID);
+        glDeleteBuffers(1, &m_IndexBufferID);
+        glDeleteBuffers(1, &m_InstanceBufferID);
+        glDeleteVertexArrays(1, &m_VertexArrayID);
+        glDeleteTextures(1, &m_CellTextureID);
+        glDeleteTextures(1, &m_PaletteTextureID);
+    }
 
-        float borderDistance = playfield.GetBorderDistance();
-        uint32_t vertexPointer = 0;
+public:
+    // Only touches the CPU copy of the cell data, the changes are sent to the GPU by Upload()
+    void SetQuad(uint32_t index, uint32_t colorIndex)
+    {
+        m_PieceTable[index] = colorIndex;
 
-        for (uint32_t i = 0; i < playfield.GetVerticalQuadCount(); i++)
-        {
-            for (uint32_t j = 0; j < playfield.GetHorizontalQuadCount(); j++)
-            {
-                float colorID = vertexPointer % 3;
+        // There is no GPU copy to update
+        if (m_RenderMode == RenderMode::Batched)
+            return;
 
-                vertices[vertexPointer * 12 + 0] = borderDistance + j * s_QuadSize;
-                vertices[vertexPointer * 12 + 1] = s_ScreenHeight - i * s_QuadSize;
-                vertices[vertexPointer * 12 + 2] = m_PieceTable[vertexPointer];
+        if (m_RenderMode == RenderMode::Quads)
+        {
+            float* quad = &m_Vertices[index * 12];
+            quad[2] = quad[5] = quad[8] = quad[11] = (float)colorIndex;
+        }
 
-                vertices[vertexPointer * 12 + 3] = borderDistance + j * s_QuadSize;
-                vertices[vertexPointer * 12 + 4] = s_ScreenHeight - (i + 1) * s_QuadSize;
-                vertices[vertexPointer * 12 + 5] = m_PieceTable[vertexPointer];
+        if (index < m_DirtyBegin)
+            m_DirtyBegin = index;
+        if (index + 1 > m_DirtyEnd)
+            m_DirtyEnd = index + 1;
+    }
 
-                vertices[vertexPointer * 12 + 6] = borderDistance + (j + 1) * s_QuadSize;
-                vertices[vertexPointer * 12 + 7] = s_ScreenHeight - (i + 1) * s_QuadSize;
-                vertices[vertexPointer * 12 + 8] = m_PieceTable[vertexPointer];
+    // Sends every quad changed since the last call with a single glBufferSubData (glTexSubImage2D in Texture mode)
+    void Upload(GLState& state)
+    {
+        if (m_DirtyBegin >= m_DirtyEnd)
+            return;
 
-                vertices[vertexPointer * 12 + 9] = borderDistance + (j + 1) * s_QuadSize;
-                vertices[vertexPointer * 12 + 10] = s_ScreenHeight - i * s_QuadSize;
-                vertices[vertexPointer * 12 + 11] = m_PieceTable[vertexPointer];
+        PROFILE_GPU_SCOPE("PieceTable::Upload");
 
-                indices[vertexPointer * 6 + 0] = 0 + 4 * vertexPointer;
-                indices[vertexPointer * 6 + 1] = 1 + 4 * vertexPointer;
-                indices[vertexPointer * 6 + 2] = 2 + 4 * vertexPointer;
-                indices[vertexPointer * 6 + 3] = 2 + 4 * vertexPointer;
-                indices[vertexPointer * 6 + 4] = 3 + 4 * vertexPointer;
-                indices[vertexPointer * 6 + 5] = 0 + 4 * vertexPointer;
+        uint32_t bytes;
+        uint32_t calls;
 
-                vertexPointer ++;
-            }
+        if (m_RenderMode == RenderMode::Texture)
+        {
+            // Whole rows, a texture update can not start in the middle of a row
+            uint32_t firstRow = m_DirtyBegin / m_ColumnCount;
+            uint32_t rowCount = (m_DirtyEnd - 1) / m_ColumnCount - firstRow + 1;
+
+            // Unit 0 is where RenderPieceTable expects the cells, the bind for drawing is elided. Whatever the bind
+            // issued (including the unit switch) counts towards the upload
+            uint32_t issued = state.GetStats().Issued;
+            state.BindTexture(0, m_CellTextureID);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, m_ColumnCount, rowCount, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &m_PieceTable[firstRow * m_ColumnCount]);
+
+            bytes = rowCount * m_ColumnCount;
+            calls = state.GetStats().Issued - issued + 1;
         }
+        else if (m_RenderMode == RenderMode::Instanced)
+        {
+            uint32_t size = m_DirtyEnd - m_DirtyBegin;
 
-        //float vertices[] = {50.0f, 50.0f, 200.0f, 50.0f, 200.0f, 200.0f, 50.0f, 200.0f};
-        //uint32_t indices[] = { 0, 1, 2, 2, 3, 0 }; 
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_InstanceBufferID);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, m_DirtyBegin, size, &m_PieceTable[m_DirtyBegin]);
 
-        glGenBuffers(1, &m_VertexBufferID);
-        glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
-        glBufferData(GL_ARRAY_BUFFER, playfield.GetVerticalQuadCount() * playfield.GetHorizontalQuadCount() * 4 * 3 * sizeof(float), vertices, GL_DYNAMIC_DRAW);
+            bytes = size;
+            calls = 2;
+        }
+        else
+        {
+            uint32_t offset = m_DirtyBegin * 12 * sizeof(float);
+            uint32_t size = (m_DirtyEnd - m_DirtyBegin) * 12 * sizeof(float);
 
-        glGenBuffers(1, &m_IndexBufferID);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, playfield.GetVerticalQuadCount() * playfield.GetHorizontalQuadCount() * 6 * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_VertexBufferID);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, &m_Vertices[m_DirtyBegin * 12]);
 
-        glGenVertexArrays(1, &m_VertexArrayID);
-        glBindVertexArray(m_VertexArrayID);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1 ,1, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (const void*)(2 * sizeof(float)));
+            bytes = size;
+            calls = 2;
+        }
+
+        m_Stats.Bytes += bytes;
+        m_Stats.Calls += calls;
+        m_Stats.MaxBytes = std::max(m_Stats.MaxBytes, bytes);
 
+        m_DirtyBegin = m_QuadCount;
+        m_DirtyEnd = 0;
     }
 
-    ~PieceTable()
+    const UploadStats& GetUploadStats() const { return m_Stats; }
+    void ResetUploadStats() { m_Stats = UploadStats(); }
+
+    uint32_t GetQuad(uint32_t id) const
     {
-        delete[] m_PieceTable;
+        return m_PieceTable[id];
     }
 
-public:
-    void SetQuad(const Playfield& playfield ,uint32_t index, uint32_t colorIndex)
+    // Mirrors the locked cells of the board plus the active piece, only changed quads are written
+    void Update(const Board& board, const Piece& activePiece)
     {
-        m_PieceTable[index] = colorIndex;
-
-        float vertices[playfield.GetVerticalQuadCount() * playfield.GetHorizontalQuadCount() * 4 * 3];
-        uint32_t indices[playfield.GetVerticalQuadCount() * playfield.GetHorizontalQuadCount() * 6];
+        PROFILE_SCOPE("PieceTable::Update");
 
-        float borderDistance = playfield.GetBorderDistance();
-        uint32_t vertexPointer = 0;
+        uint8_t cells[Board::Width * Board::Height];
 
-        glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+        for (uint32_t i = 0; i < Board::Width * Board::Height; i++)
+            cells[i] = board.GetCell(i);
 
-        float data[] = {
-            playfield.GetBorderDistance() + (index % playfield.GetHorizontalQuadCount()) * s_QuadSize, s_ScreenHeight - (int)((int)index / playfield.GetHorizontalQuadCount()) * s_QuadSize, (float)colorIndex,
-            playfield.GetBorderDistance() + (index % playfield.GetHorizontalQuadCount()) * s_QuadSize, s_ScreenHeight - ((int)((int)index / playfield.GetHorizontalQuadCount()) + 1) * s_QuadSize, (float)colorIndex,
-            playfield.GetBorderDistance() + ((index % playfield.GetHorizontalQuadCount()) + 1) * s_QuadSize, s_ScreenHeight - ((int)((int)index / playfield.GetHorizontalQuadCount()) + 1) * s_QuadSize, (float)colorIndex,
-            playfield.GetBorderDistance() + ((index % playfield.GetHorizontalQuadCount()) + 1) * s_QuadSize, s_ScreenHeight - (int)((int)index / playfield.GetHorizontalQuadCount()) * s_QuadSize, (float)colorIndex
-            };
+        activePiece.Overlay(cells);
 
-        glBufferSubData(GL_ARRAY_BUFFER, index * 12 * sizeof(float), sizeof(data), &data);
-    }
-
-    uint32_t GetQuad(uint32_t id)
-    {
-        return m_PieceTable[id];
-    }
-
-    void Fall(Playfield playfield, uint32_t row)
-    {
-        for (uint32_t i = 0; i < row; i++)
+        for (uint32_t i = 0; i < Board::Width * Board::Height; i++)
         {
-            for (uint32_t j = 0; j < 10; j++)
-            {
-                SetQuad(playfield, row * 10 - i * 10 + j, GetQuad(row * 10 - i * 10 + j - 10));
-            }
+            if (cells[i] != m_PieceTable[i])
+                SetQuad(i, cells[i]);
         }
     }
 
@@ -187,257 +261,235 @@ public:
     uint32_t GetVertexBufferID() const { return m_VertexBufferID; }
     uint32_t GetIndexBufferID() const { return m_IndexBufferID; }
     uint32_t GetVertexArrayID() const { return m_VertexArrayID; }
+    uint32_t GetCellTextureID() const { return m_CellTextureID; }
+    uint32_t GetPaletteTextureID() const { return m_PaletteTextureID; }
+
+    RenderMode GetRenderMode() const { return m_RenderMode; }
+    uint32_t GetQuadCount() const { return m_QuadCount; }
+    uint32_t GetColumnCount() const { return m_ColumnCount; }
+    float GetQuadSize() const { return m_QuadSize; }
+    const glm::vec2& GetOrigin() const { return m_Origin; }
 
 private:
     uint32_t m_VertexBufferID;
     uint32_t m_IndexBufferID;
     uint32_t m_VertexArrayID;
+    uint32_t m_InstanceBufferID;
+    uint32_t m_CellTextureID;
+    uint32_t m_PaletteTextureID;
+
+    RenderMode m_RenderMode;
+    uint32_t m_QuadCount;
+    uint32_t m_ColumnCount;
+    float m_QuadSize;
+    glm::vec2 m_Origin;
+
+    std::vector<uint8_t> m_PieceTable;
+    std::vector<float> m_Vertices;
+    uint32_t m_DirtyBegin;
+    uint32_t m_DirtyEnd;
+    UploadStats m_Stats;
 
-    uint32_t* m_PieceTable;
-};
-
-class Piece
-{
-public:
-    Piece(const float* pieceMap, float colorID)
-        : m_ColorID(colorID)
-    {   
-        for (uint32_t i = 0; i < 9; i++)
-        {
-            m_PieceMap[i] = pieceMap[i];
-        }
-    }
-
-    ~Piece()
-    {}
-public:
-    void Respawn()
+private:
+    void CreateQuadBuffers(const Playfield& playfield)
     {
-        m_Position = 15;
-        m_Landed = false;
-    }
+        m_Vertices.resize(m_QuadCount * 4 * 3);
 
-    void Spawn(PieceTable& pieceTable, const Playfield& playfield)
-    {
-        for (uint32_t i = 0; i < 9; i++)
-        {
-            if (m_PieceMap[i] == 0)
-                continue;
-            
-            int x = -1 + i % 3;
-            int y = 1 - (int)((int)i / 3);
+        float* vertices = m_Vertices.data();
+        std::vector<uint32_t> indices(m_QuadCount * 6);
 
-            pieceTable.SetQuad(playfield, m_Position + playfield.GetHorizontalQuadCount() * y * -1 + x, m_ColorID);
-        }   
-    }
+        float borderDistance = playfield.GetBorderDistance();
+        float screenHeight = playfield.GetScreenHeight();
+        uint32_t vertexPointer = 0;
 
-    void Clear(PieceTable& pieceTable, const Playfield& playfield)
-    {
-        for (uint32_t i = 0; i < 9; i++)
+        for (uint32_t i = 0; i < playfield.GetVerticalQuadCount(); i++)
         {
-            if (m_PieceMap[i] == 0)
-                continue;
-            
-            int x = -1 + i % 3;
-            int y = 1 - (int)((int)i / 3);
-
-            pieceTable.SetQuad(playfield, m_Position + playfield.GetHorizontalQuadCount() * y * -1 + x, 0.0f);
-        }
-    }
-
-    void Move(PieceTable& pieceTable, const Playfield& playfield)
-    {
-       // For each quad
-       for (uint32_t i = 0; i < 9; i++)
-       {
-           if (m_PieceMap[i] == 0)
-                continue;
-            
-            bool covered = false;
-
-            for (uint32_t j = 0; j < (int)((8 - i)) / 3; j++)
-            {
-                if (m_PieceMap[i + 3 * (j + 1)] == 1.0f)
-                {
-                    covered = true;
-                    break;
-                }
-            }
-
-            if (covered)
-                continue;
-
-            int x = -1 + i % 3;
-            int y = 1 - (int)((int)i / 3);
-
-            if (m_Position + playfield.GetHorizontalQuadCount() * y * -1 + 10 >= 200)
+            for (uint32_t j = 0; j < playfield.GetHorizontalQuadCount(); j++)
             {
-                m_Landed = true;
-                break;
-            }
+                vertices[vertexPointer * 12 + 0] = borderDistance + j * m_QuadSize;
+                vertices[vertexPointer * 12 + 1] = screenHeight - i * m_QuadSize;
+                vertices[vertexPointer * 12 + 2] = m_PieceTable[vertexPointer];
 
-            if (pieceTable.GetQuad(m_Position + playfield.GetHorizontalQuadCount() * y * -1 + x + 10) != 0)
-            {
-                m_Landed = true;
-                break;
-            }
-       }
+                vertices[vertexPointer * 12 + 3] = borderDistance + j * m_QuadSize;
+                vertices[vertexPointer * 12 + 4] = screenHeight - (i + 1) * m_QuadSize;
+                vertices[vertexPointer * 12 + 5] = m_PieceTable[vertexPointer];
 
-        if (!m_Landed)
-        {
-            Clear(pieceTable, playfield);
-            m_Position += 10;
-            Spawn(pieceTable, playfield);
-        }
-    }
+                vertices[vertexPointer * 12 + 6] = borderDistance + (j + 1) * m_QuadSize;
+                vertices[vertexPointer * 12 + 7] = screenHeight - (i + 1) * m_QuadSize;
+                vertices[vertexPointer * 12 + 8] = m_PieceTable[vertexPointer];
 
-    void MoveLeft(PieceTable& pieceTable, const Playfield& playfield)
-    {
-        for (uint32_t i = 0; i < 9; i++)
-        {
-            if (m_PieceMap[i] == 0)
-                continue;
+                vertices[vertexPointer * 12 + 9] = borderDistance + (j + 1) * m_QuadSize;
+                vertices[vertexPointer * 12 + 10] = screenHeight - i * m_QuadSize;
+                vertices[vertexPointer * 12 + 11] = m_PieceTable[vertexPointer];
 
-            bool covered = false;
+                indices[vertexPointer * 6 + 0] = 0 + 4 * vertexPointer;
+                indices[vertexPointer * 6 + 1] = 1 + 4 * vertexPointer;
+                indices[vertexPointer * 6 + 2] = 2 + 4 * vertexPointer;
+                indices[vertexPointer * 6 + 3] = 2 + 4 * vertexPointer;
+                indices[vertexPointer * 6 + 4] = 3 + 4 * vertexPointer;
+                indices[vertexPointer * 6 + 5] = 0 + 4 * vertexPointer;
 
-            for (uint32_t j = 0; j < i % 3; j++)
-            {
-                if (m_PieceMap[i - (j + 1)] == 1.0f)
-                {
-                    covered = true;
-                    break;
-                }             
+                vertexPointer ++;
             }
+        }
 
-            if (covered)
-                continue;
-
-            int x = -1 + i % 3;
-            int y = 1 - (int)((int)i / 3);
-
-            if ((m_Position + x - 1) % 10 == 9)
-                return;
-
-            if (pieceTable.GetQuad(m_Position + (int)playfield.GetHorizontalQuadCount() * y * -1 + x - 1) != 0)
-                return; 
+        glGenBuffers(1, &m_VertexBufferID);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+        glBufferData(GL_ARRAY_BUFFER, m_Vertices.size() * sizeof(float), m_Vertices.data(), GL_DYNAMIC_DRAW);
 
-        }
+        glGenBuffers(1, &m_IndexBufferID);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
 
-        Clear(pieceTable, playfield);
-        m_Position -= 1;
-        Spawn(pieceTable, playfield);
+        glGenVertexArrays(1, &m_VertexArrayID);
+        glBindVertexArray(m_VertexArrayID);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1 ,1, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (const void*)(2 * sizeof(float)));
+        glBindVertexArray(0);
     }
 
-    void MoveRight(PieceTable& pieceTable, const Playfield& playfield)
+    void CreateInstancedBuffers()
     {
-        for (uint32_t i = 0; i < 9; i++)
-        {
-            if (m_PieceMap[i] == 0)
-                continue;
+        // Corners of a unit cell, y grows downwards like the rows of the board
+        float vertices[] = {
+            0.0f, 0.0f,
+            0.0f, 1.0f,
+            1.0f, 1.0f,
+            1.0f, 0.0f
+        };
 
-            bool covered = false;
+        uint32_t indices[] = { 0, 1, 2, 2, 3, 0 };
 
-            for (uint32_t j = 0; j < (8 - i) % 3; j++)
-            {
-                if (m_PieceMap[i + j + 1] == 1.0f)
-                {
-                    covered = true;
-                    break;
-                }             
-            }
+        glGenBuffers(1, &m_VertexBufferID);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-            if (covered)
-                continue;
+        glGenBuffers(1, &m_IndexBufferID);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-            int x = -1 + i % 3;
-            int y = 1 - (int)((int)i / 3);
+        glGenVertexArrays(1, &m_VertexArrayID);
+        glBindVertexArray(m_VertexArrayID);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
 
-            if ((m_Position + x + 1) % 10 == 0)
-                return;
+        glGenBuffers(1, &m_InstanceBufferID);
+        glBindBuffer(GL_ARRAY_BUFFER, m_InstanceBufferID);
+        glBufferData(GL_ARRAY_BUFFER, m_PieceTable.size(), m_PieceTable.data(), GL_DYNAMIC_DRAW);
 
-            if (pieceTable.GetQuad(m_Position + (int)playfield.GetHorizontalQuadCount() * y * -1 + x + 1) != 0)
-                return;           
-        }
+        glEnableVertexAttribArray(1);
+        glVertexAttribIPointer(1, 1, GL_UNSIGNED_BYTE, sizeof(uint8_t), nullptr);
+        glVertexAttribDivisor(1, 1);
 
-        Clear(pieceTable, playfield);
-        m_Position += 1;
-        Spawn(pieceTable, playfield);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
-    void Rotate(PieceTable& pieceTable, const Playfield& playfield)
+    void CreateTextures(const Playfield& playfield)
     {
-        Clear(pieceTable, playfield);
-
-        float tempPieceMap[9] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; 
-
-        for (uint32_t i = 0; i < 9; i++)
-        {
-            int x = -1 + i % 3;
-            int y = 1 - (int)((int)i / 3);
-
-            int newX = 0 - y;
-            int newY = x;
-            
-            int deltaX = (m_Position + newX) % 10 - (m_Position + x) % 10;
+        float left = playfield.GetBorderDistance();
+        float top = playfield.GetScreenHeight();
+        float right = left + playfield.GetHorizontalQuadCount() * m_QuadSize;
+        float bottom = top - playfield.GetVerticalQuadCount() * m_QuadSize;
+        float columns = playfield.GetHorizontalQuadCount();
+        float rows = playfield.GetVerticalQuadCount();
+
+        // Position and cell coordinate of every corner, row 0 is the top row of the board
+        float vertices[] = {
+            left, top, 0.0f, 0.0f,
+            left, bottom, 0.0f, rows,
+            right, bottom, columns, rows,
+            right, top, columns, 0.0f
+        };
 
-            if (abs(deltaX) > 2)
-            {
-                Spawn(pieceTable, playfield);
-                return;
-            }
+        uint32_t indices[] = { 0, 1, 2, 2, 3, 0 };
 
-            if (m_Position + playfield.GetHorizontalQuadCount() * newY * -1 + 10 >= 200)
-            {
-                Spawn(pieceTable, playfield);
-                return;
-            }
+        glGenBuffers(1, &m_VertexBufferID);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-            if (pieceTable.GetQuad(m_Position + (int)playfield.GetHorizontalQuadCount() * newY * -1 + newX) != 0)
-            {
-                Spawn(pieceTable, playfield);
-                return;
-            }
+        glGenBuffers(1, &m_IndexBufferID);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-            tempPieceMap[(1 - newY) * 3 + (newX + 1)] = m_PieceMap[i];
-        }
+        glGenVertexArrays(1, &m_VertexArrayID);
+        glBindVertexArray(m_VertexArrayID);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (const void*)(2 * sizeof(float)));
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        for (uint32_t i = 0; i < 9; i++)
-        {
-            m_PieceMap[i] = tempPieceMap[i];
-        }
-    
-        Spawn(pieceTable, playfield);
+        // Rows of the board are not 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        glGenTextures(1, &m_CellTextureID);
+        glBindTexture(GL_TEXTURE_2D, m_CellTextureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, m_ColumnCount, m_QuadCount / m_ColumnCount, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, m_PieceTable.data());
+
+        glGenTextures(1, &m_PaletteTextureID);
+        glBindTexture(GL_TEXTURE_2D, m_PaletteTextureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, sizeof(Palette) / 4, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, Palette);
+        glBindTexture(GL_TEXTURE_2D, 0);
     }
-
-    bool IsLanded() const { return m_Landed; }
-    uint32_t GetPosiion() const { return m_Position; }
-
-private:
-    float m_ColorID;
-    float m_PieceMap[9];
-    uint32_t m_Position = 15;
-    bool m_Landed = false;
 };
 
 class Renderer
 {
 public:
-    Renderer()
-        : m_ShaderID(0), m_ProjectionMatrix(glm::ortho(0.0f, (float)s_ScreenWidth, 0.0f, (float)s_ScreenHeight)), m_ColorUniformLocation(0.0f), m_ProjectionMatrixUniformLocation(0.0f)
+    // Layers of the batched frame, higher ones are drawn on top. The right border line covers the last column of
+    // cells, as it did when the depth test rejected the cells drawn after it
+    enum BatchLayer : uint8_t
+    {
+        PieceLayer,
+        BoardLayer,
+        HUDLayer
+    };
+
+public:
+    // The programs are built by the shader manager (together with the ones of the other renderers) before the
+    // renderer is created
+    static void LoadShaders(ShaderManager& shaderManager)
     {
-        glEnable(GL_DEPTH_TEST);
+        shaderManager.Load("Renderer.Playfield", VertexShaderSource, FragmentShaderSource);
+        shaderManager.Load("Renderer.PieceTable", VertexShaderSourcePieceTable, FragmentShaderSourcePieceTable);
+        shaderManager.Load("Renderer.InstancedPieceTable", VertexShaderSourceInstancedPieceTable, FragmentShaderSourceInstancedPieceTable);
+        shaderManager.Load("Renderer.TexturePieceTable", VertexShaderSourceTexturePieceTable, FragmentShaderSourceTexturePieceTable);
+    }
+
+    Renderer(GLState& state, const ShaderManager& shaderManager)
+        : m_State(state), m_ShaderID(0), m_TransformationMatrix(1.0f), m_ColorUniformLocation(0), m_TransformationMatrixUniformLocation(0)
+    {
+        m_State.SetDepthTest(true);
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-        m_ShaderID = CreateShader(VertexShaderSource, FragmentShaderSource);
-        m_PieceTableShaderID = CreateShader(VertexShaderSourcePieceTable, FragmentShaderSourcePieceTable);
+        m_ShaderID = shaderManager.GetProgram("Renderer.Playfield");
+        m_PieceTableShaderID = shaderManager.GetProgram("Renderer.PieceTable");
+        m_InstancedPieceTableShaderID = shaderManager.GetProgram("Renderer.InstancedPieceTable");
+        m_TexturePieceTableShaderID = shaderManager.GetProgram("Renderer.TexturePieceTable");
 
         m_ColorUniformLocation = glGetUniformLocation(m_ShaderID, "u_Color");
-        m_ProjectionMatrixUniformLocation = glGetUniformLocation(m_ShaderID, "u_ProjectionMatrix");
         m_TransformationMatrixUniformLocation = glGetUniformLocation(m_ShaderID, "u_TransformationMatrix");
 
-        m_PieceTableProjectionMatrixUniformLocation = glGetUniformLocation(m_PieceTableShaderID, "u_ProjectionMatrix");
+        m_InstancedOriginUniformLocation = glGetUniformLocation(m_InstancedPieceTableShaderID, "u_Origin");
+        m_InstancedQuadSizeUniformLocation = glGetUniformLocation(m_InstancedPieceTableShaderID, "u_QuadSize");
+        m_InstancedColumnCountUniformLocation = glGetUniformLocation(m_InstancedPieceTableShaderID, "u_ColumnCount");
+
+        m_State.UseProgram(m_TexturePieceTableShaderID);
+        m_State.SetUniform(glGetUniformLocation(m_TexturePieceTableShaderID, "u_Cells"), 0);
+        m_State.SetUniform(glGetUniformLocation(m_TexturePieceTableShaderID, "u_Palette"), 1);
     }
     ~Renderer()
     {}
@@ -445,46 +497,101 @@ public:
 public:
     void Clear(const glm::vec4& color)
     {
+        m_State.SetClearColor(color);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glClearColor(color.r, color.g, color.b, color.a);
     }
 
+    // The index buffer is part of the vertex array, binding the vertex array is all a draw needs, and nothing is
+    // unbound afterwards so that the next frame finds its state already in place
     void RenderPlayfield(const Playfield& playfield, const glm::vec4& color)
     {
-        glBindVertexArray(playfield.GetVertexArrayID());
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, playfield.GetIndexBufferID());
-
-        glUseProgram(m_ShaderID);
+        PROFILE_GPU_SCOPE("Renderer::RenderPlayfield");
 
-        glm::mat4 m_TransformationMatrix(1.0f);
+        // The batch turns it off
+        m_State.SetDepthTest(true);
+        m_State.BindVertexArray(playfield.GetVertexArrayID());
+        m_State.UseProgram(m_ShaderID);
 
-        glUniform4f(m_ColorUniformLocation, color.r, color.g, color.b, color.a);
-        glUniformMatrix4fv(m_ProjectionMatrixUniformLocation, 1, GL_FALSE, &m_ProjectionMatrix[0][0]);
-        glUniformMatrix4fv(m_TransformationMatrixUniformLocation, 1, GL_FALSE, &m_TransformationMatrix[0][0]);
+        m_State.SetUniform(m_ColorUniformLocation, color);
+        m_State.SetUniform(m_TransformationMatrixUniformLocation, m_TransformationMatrix);
 
         glDrawElements(GL_LINES, 4, GL_UNSIGNED_INT, nullptr);
-        
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        m_State.CountDrawCall();
     }
 
     void RenderPieceTable(const PieceTable& pieceTable)
     {
-        glBindVertexArray(pieceTable.GetVertexArrayID());
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pieceTable.GetIndexBufferID());
+        // Batched tables have nothing to draw here, see SubmitPieceTable
+        if (pieceTable.GetRenderMode() == PieceTable::RenderMode::Batched)
+            return;
 
-        glUseProgram(m_PieceTableShaderID);
+        PROFILE_GPU_SCOPE("Renderer::RenderPieceTable");
 
-        glUniformMatrix4fv(m_PieceTableProjectionMatrixUniformLocation, 1, GL_FALSE, &m_ProjectionMatrix[0][0]);
+        m_State.SetDepthTest(true);
+        m_State.BindVertexArray(pieceTable.GetVertexArrayID());
 
-        glDrawElements(GL_TRIANGLES, 10 * 20 * 6, GL_UNSIGNED_INT, nullptr);
-        
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        if (pieceTable.GetRenderMode() == PieceTable::RenderMode::Instanced)
+        {
+            m_State.UseProgram(m_InstancedPieceTableShaderID);
+
+            m_State.SetUniform(m_InstancedOriginUniformLocation, pieceTable.GetOrigin());
+            m_State.SetUniform(m_InstancedQuadSizeUniformLocation, pieceTable.GetQuadSize());
+            m_State.SetUniform(m_InstancedColumnCountUniformLocation, (int)pieceTable.GetColumnCount());
+
+            glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, pieceTable.GetQuadCount());
+            m_State.CountDrawCall();
+        }
+        else if (pieceTable.GetRenderMode() == PieceTable::RenderMode::Texture)
+        {
+            m_State.UseProgram(m_TexturePieceTableShaderID);
+
+            m_State.BindTexture(0, pieceTable.GetCellTextureID());
+            m_State.BindTexture(1, pieceTable.GetPaletteTextureID());
+
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+            m_State.CountDrawCall();
+        }
+        else
+        {
+            m_State.UseProgram(m_PieceTableShaderID);
+
+            glDrawElements(GL_TRIANGLES, pieceTable.GetQuadCount() * 6, GL_UNSIGNED_INT, nullptr);
+            m_State.CountDrawCall();
+        }
+    }
+
+    // The border lines as one pixel wide quads, on the pixel column left of the line position where GL_LINES put them
+    void SubmitPlayfield(BatchRenderer& batchRenderer, const Playfield& playfield, const glm::vec4& color)
+    {
+        uint32_t packedColor = BatchRenderer::PackColor(color);
+        float left = (float)playfield.GetBorderDistance();
+        float right = (float)playfield.GetScreenWidth() - (float)playfield.GetBorderDistance();
+        float height = (float)playfield.GetScreenHeight();
+
+        batchRenderer.Submit(BoardLayer, glm::vec2(left - 1.0f, height), glm::vec2(left, 0.0f), packedColor);
+        batchRenderer.Submit(BoardLayer, glm::vec2(right - 1.0f, height), glm::vec2(right, 0.0f), packedColor);
+    }
+
+    // One solid quad per filled cell, read from the CPU copy of the table whatever its render mode
+    void SubmitPieceTable(BatchRenderer& batchRenderer, const PieceTable& pieceTable)
+    {
+        PROFILE_SCOPE("Renderer::SubmitPieceTable");
+
+        uint32_t colors[sizeof(PieceTable::Palette) / 4];
+        std::memcpy(colors, PieceTable::Palette, sizeof(colors));
+
+        float quadSize = pieceTable.GetQuadSize();
+
+        for (uint32_t i = 0; i < pieceTable.GetQuadCount(); i++)
+        {
+            uint32_t colorID = pieceTable.GetQuad(i);
+            if (colorID == 0)
+                continue;
+
+            // Row 0 is the top row of the board
+            glm::vec2 topLeft = pieceTable.GetOrigin() + glm::vec2((i % pieceTable.GetColumnCount()) * quadSize, -(float)(i / pieceTable.GetColumnCount()) * quadSize);
+            batchRenderer.Submit(PieceLayer, topLeft, topLeft + glm::vec2(quadSize, -quadSize), colors[colorID]);
+        }
     }
 
 private:
@@ -492,44 +599,26 @@ private:
     static const std::string FragmentShaderSource;
     static const std::string VertexShaderSourcePieceTable;
     static const std::string FragmentShaderSourcePieceTable;
-    
+    static const std::string VertexShaderSourceInstancedPieceTable;
+    static const std::string FragmentShaderSourceInstancedPieceTable;
+    static const std::string VertexShaderSourceTexturePieceTable;
+    static const std::string FragmentShaderSourceTexturePieceTable;
+
+    GLState& m_State;
+
     uint32_t m_ShaderID;
     uint32_t m_PieceTableShaderID;
+    uint32_t m_InstancedPieceTableShaderID;
+    uint32_t m_TexturePieceTableShaderID;
 
-    glm::mat4 m_ProjectionMatrix;
     glm::mat4 m_TransformationMatrix;
 
     int m_ColorUniformLocation;
-    int m_ProjectionMatrixUniformLocation;
     int m_TransformationMatrixUniformLocation;
 
-    int m_PieceTableProjectionMatrixUniformLocation;
-
-private:
-    uint32_t CreateShader(const std::string& vertexSource, const std::string& fragmentSource)
-    {
-        uint32_t id = glCreateProgram();
-        uint32_t vs = glCreateShader(GL_VERTEX_SHADER);
-        uint32_t fs = glCreateShader(GL_FRAGMENT_SHADER);
-
-        const char* src = vertexSource.c_str();
-        glShaderSource(vs, 1, &src, nullptr);
-        src = fragmentSource.c_str();
-        glShaderSource(fs, 1, &src, nullptr);
-
-        glCompileShader(vs);
-        glCompileShader(fs);
-
-        glAttachShader(id, vs);
-        glAttachShader(id, fs);
-        glLinkProgram(id);
-        glValidateProgram(id);
-
-        glDeleteShader(vs);
-        glDeleteShader(fs);
-
-        return id;
-    }
+    int m_InstancedOriginUniformLocation;
+    int m_InstancedQuadSizeUniformLocation;
+    int m_InstancedColumnCountUniformLocation;
 };
 
 const std::string Renderer::VertexShaderSource =
@@ -537,7 +626,10 @@ const std::string Renderer::VertexShaderSource =
     "\n"
     "layout(location = 0) in vec4 position;\n"
     "\n"
-    "uniform mat4 u_ProjectionMatrix;\n"
+    "layout(std140) uniform Projection\n"
+    "{\n"
+    "   mat4 u_ProjectionMatrix;\n"
+    "};\n"
     "uniform mat4 u_TransformationMatrix;\n"
     "\n"
     "void main()\n"
@@ -565,7 +657,10 @@ const std::string Renderer::VertexShaderSourcePieceTable =
     "\n"
     "out float out_ColorID;\n"
     "\n"
-    "uniform mat4 u_ProjectionMatrix;\n"
+    "layout(std140) uniform Projection\n"
+    "{\n"
+    "   mat4 u_ProjectionMatrix;\n"
+    "};\n"
     "\n"
     "void main()\n"
     "{\n"
@@ -605,24 +700,284 @@ const std::string Renderer::FragmentShaderSourcePieceTable =
     "   case 6:\n"
     "       color = vec4(1.0, 0.0, 0.0, 1.0);\n"
     "       break;\n"
+    "   case 7:\n"
+    "       color = vec4(0.0, 1.0, 1.0, 1.0);\n"
+    "       break;\n"
     "   }\n"
     "}\n";
 
-int main()
+const std::string Renderer::VertexShaderSourceInstancedPieceTable =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) in vec2 corner;\n"
+    "layout(location = 1) in uint colorID;\n"
+    "\n"
+    "flat out uint v_ColorID;\n"
+    "\n"
+    "layout(std140) uniform Projection\n"
+    "{\n"
+    "   mat4 u_ProjectionMatrix;\n"
+    "};\n"
+    "uniform vec2 u_Origin;\n"
+    "uniform float u_QuadSize;\n"
+    "uniform int u_ColumnCount;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   vec2 cell = vec2(gl_InstanceID % u_ColumnCount, gl_InstanceID / u_ColumnCount) + corner;\n"
+    "   gl_Position = u_ProjectionMatrix * vec4(u_Origin.x + cell.x * u_QuadSize, u_Origin.y - cell.y * u_QuadSize, 0.0, 1.0);\n"
+    "   v_ColorID = colorID;\n"
+    "}\n";
+
+const std::string Renderer::FragmentShaderSourceInstancedPieceTable =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) out vec4 color;\n"
+    "\n"
+    "flat in uint v_ColorID;\n"
+    "\n"
+    "const vec4 palette[8] = vec4[8](\n"
+    "   vec4(0.0, 0.0, 0.0, 0.0),\n"
+    "   vec4(0.0, 0.0, 1.0, 1.0),\n"
+    "   vec4(1.0, 0.65, 0.0, 1.0),\n"
+    "   vec4(1.0, 1.0, 0.0, 1.0),\n"
+    "   vec4(0.0, 1.0, 0.0, 1.0),\n"
+    "   vec4(0.5, 0.0, 0.5, 1.0),\n"
+    "   vec4(1.0, 0.0, 0.0, 1.0),\n"
+    "   vec4(0.0, 1.0, 1.0, 1.0)\n"
+    ");\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   color = palette[v_ColorID];\n"
+    "}\n";
+
+const std::string Renderer::VertexShaderSourceTexturePieceTable =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) in vec4 position;\n"
+    "layout(location = 1) in vec2 cell;\n"
+    "\n"
+    "out vec2 v_Cell;\n"
+    "\n"
+    "layout(std140) uniform Projection\n"
+    "{\n"
+    "   mat4 u_ProjectionMatrix;\n"
+    "};\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = u_ProjectionMatrix * position;\n"
+    "   v_Cell = cell;\n"
+    "}\n";
+
+const std::string Renderer::FragmentShaderSourceTexturePieceTable =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) out vec4 color;\n"
+    "\n"
+    "in vec2 v_Cell;\n"
+    "\n"
+    "uniform usampler2D u_Cells;\n"
+    "uniform sampler2D u_Palette;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   uint colorID = texelFetch(u_Cells, ivec2(v_Cell), 0).r;\n"
+    "   color = texelFetch(u_Palette, ivec2(colorID, 0), 0);\n"
+    "}\n";
+
+// Renders the same sequence of board updates with every PieceTable render mode, one result line per mode. The bytes
+// of the batched mode are the vertices it streams
+static void RunRenderBenchmark(GLFWwindow* window, GLState& state, const Playfield& playfield, Renderer& renderer, BatchRenderer& batchRenderer, uint32_t frameCount)
 {
+    const PieceTable::RenderMode renderModes[] = { PieceTable::RenderMode::Quads, PieceTable::RenderMode::Instanced, PieceTable::RenderMode::Texture, PieceTable::RenderMode::Batched };
+    const char* renderModeNames[] = { "quads", "instanced", "texture", "batched" };
+
+    glfwSwapInterval(0);
+
+    for (uint32_t mode = 0; mode < 4; mode++)
+    {
+        PieceTable pieceTable(playfield, renderModes[mode]);
+        uint64_t uploadedBytes = 0;
+        uint64_t streamedBytes = batchRenderer.GetStreamedBytes();
+
+        // The objects of the previous mode were deleted, their names may come back for this one
+        state.Invalidate();
+        state.ResetStats();
+
+        srand(1);
+
+        auto startTimepoint = std::chrono::high_resolution_clock::now();
+
+        for (uint32_t frame = 0; frame < frameCount; frame++)
+        {
+            // A falling piece rewrites 8 cells, every 30th frame a line clear rewrites the whole board
+            uint32_t cellCount = frame % 30 == 0 ? pieceTable.GetQuadCount() : 8;
+            uint32_t firstCell = rand() % (pieceTable.GetQuadCount() - cellCount + 1);
+
+            for (uint32_t i = firstCell; i < firstCell + cellCount; i++)
+                pieceTable.SetQuad(i, rand() % (Tetromino::Count + 1));
+
+            pieceTable.ResetUploadStats();
+            pieceTable.Upload(state);
+            uploadedBytes += pieceTable.GetUploadStats().Bytes;
+
+            renderer.Clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+            if (renderModes[mode] == PieceTable::RenderMode::Batched)
+            {
+                renderer.SubmitPlayfield(batchRenderer, playfield, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+                renderer.SubmitPieceTable(batchRenderer, pieceTable);
+                batchRenderer.Flush();
+            }
+            else
+            {
+                renderer.RenderPlayfield(playfield, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+                renderer.RenderPieceTable(pieceTable);
+            }
+
+            glfwSwapBuffers(window);
+        }
+
+        glFinish();
+
+        uploadedBytes += batchRenderer.GetStreamedBytes() - streamedBytes;
+
+        std::chrono::duration<double, std::micro> duration = std::chrono::high_resolution_clock::now() - startTimepoint;
+
+        std::cout << "benchmark mode=" << renderModeNames[mode] << " frames=" << frameCount
+                  << " us_per_frame=" << duration.count() / frameCount
+                  << " bytes_per_frame=" << (double)uploadedBytes / frameCount
+                  << " gl_calls_per_frame=" << (double)state.GetStats().Issued / frameCount
+                  << " gl_calls_elided_per_frame=" << (double)state.GetStats().Elided / frameCount
+                  << " draws_per_frame=" << (double)state.GetStats().DrawCalls / frameCount << std::endl;
+    }
+}
+
+// Re-runs a recorded session without a window and checks that it ends in the recorded state
+static int RunReplay(const std::string& replayPath)
+{
+    Replay replay;
+    if (!replay.Load(replayPath))
+        return -1;
+
+    Game game(replay.GetSeed());
+
+    auto startTimepoint = std::chrono::high_resolution_clock::now();
+    bool matches = replay.Play(game);
+    std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - startTimepoint;
+
+    std::cout << "replay ticks=" << game.GetTick() << " pieces=" << game.GetPieceCount() << " lines=" << game.GetLines()
+              << " score=" << game.GetScore() << " ms=" << duration.count() << " hash=" << std::hex << game.GetStateHash() << std::dec
+              << " result=" << (matches ? "match" : "mismatch") << std::endl;
+
+    return matches ? 0 : 1;
+}
+
+// Identifies everything the board view shows, frames in which it did not change are not rendered
+static uint64_t GetViewKey(const Game& game)
+{
+    const Piece& piece = game.GetActivePiece();
+    uint64_t pieceKey = ((uint64_t)piece.GetType() << 24) | ((uint64_t)(uint8_t)piece.GetX() << 16) | ((uint64_t)(uint8_t)piece.GetY() << 8) | piece.GetRotation();
+
+    return game.GetBoard().GetHash() ^ Random(pieceKey).Next();
+}
+
+int main(int argc, char** argv)
+{
+    std::string replayPath;
+    std::string recordPath;
+    uint64_t seed = time(NULL);
+    bool benchmark = false;
+    bool useBot = false;
+    bool batched = true;
+    uint32_t benchmarkFrames = 2000;
+    FrameScheduler::Settings frameSettings;
+    InputQueue::Settings inputSettings;
+    uint32_t screenWidth = 640;
+    uint32_t screenHeight = 480;
+#ifdef TETRIS_PROFILE
+    std::string tracePath;
+#endif
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+
+        if (argument == "--replay" && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (argument == "--record" && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (argument == "--bot")
+            useBot = true;
+        else if (argument == "--direct")
+            batched = false;
+        else if (argument == "--seed" && i + 1 < argc)
+            seed = std::stoull(argv[++i]);
+        else if (argument == "--no-vsync")
+            frameSettings.VSync = false;
+        else if (argument == "--fps" && i + 1 < argc)
+            frameSettings.MaxFrameRate = std::stod(argv[++i]);
+        else if (argument == "--always-render")
+            frameSettings.RenderOnChange = false;
+        else if (argument == "--frame-stats")
+            frameSettings.ReportStats = true;
+        else if (argument == "--das" && i + 1 < argc)
+            inputSettings.DelayedAutoShift = std::stod(argv[++i]) / 1000.0;
+        else if (argument == "--arr" && i + 1 < argc)
+            inputSettings.AutoRepeatRate = std::stod(argv[++i]) / 1000.0;
+#ifdef TETRIS_PROFILE
+        else if (argument == "--trace" && i + 1 < argc)
+            tracePath = argv[++i];
+#endif
+        else if (argument == "--benchmark")
+        {
+            benchmark = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                benchmarkFrames = std::stoi(argv[++i]);
+        }
+    }
+
+    if (!replayPath.empty())
+        return RunReplay(replayPath);
+
+    // Assets are read and decoded on loader threads while the window, the context and the shaders are created, their
+    // textures are uploaded into the texture arrays of the 2D batch (their own textures with --direct) once the renderers
+    // exist. The baked font is mapped and uploaded as is, the BMFont text file and PNG are the fallback when it was not
+    // baked
+    Font font;
+    bool bakedFont = false;
+    BatchRenderer* uploadBatchRenderer = nullptr;
+
+    AssetLoader assetLoader;
+    assetLoader.Submit("font", [&]()
+    {
+        bakedFont = font.LoadBaked("res/fonts/tahoma.font");
+        return bakedFont || font.Load("res/fonts/tahoma.fnt", "res/fonts/tahoma.png");
+    }, [&](bool loaded)
+    {
+        if (loaded && batched)
+            uploadBatchRenderer->GetFontTexture(font);
+        else if (loaded)
+            font.UploadTexture();
+    });
+
     if (!glfwInit())
     {
         std::cout << "Failed to initialize GLFW!" << std::endl;
         return -1;
     }
 
+    assetLoader.Mark("glfw");
+
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     GLFWwindow* window;
-    window = glfwCreateWindow(s_ScreenWidth, s_ScreenHeight, "Hello There", NULL, NULL);
+    window = glfwCreateWindow(screenWidth, screenHeight, "Hello There", NULL, NULL);
     if (!window)
     {
         std::cout << "Failed to create window!" << std::endl;
@@ -630,6 +985,8 @@ int main()
         return -1;
     }
 
+    assetLoader.Mark("window");
+
     glfwMakeContextCurrent(window);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -644,196 +1001,265 @@ int main()
     std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
     std::cout << "Version: " << glGetString(GL_VERSION) << std::endl;
 
-    Playfield playfield(10, 20);
-    PieceTable pieceTable(playfield);
+    assetLoader.Mark("context");
 
-    // J
-    float JpieceMap[] = {
-        1.0f, 0.0f, 0.0f,
-        1.0f, 1.0f, 1.0f,
-        0.0f, 0.0f, 0.0f    
-    };
+    Playfield playfield(screenWidth, screenHeight, Board::Width, Board::Height);
+    // --direct keeps the instanced board and the text renderer, for comparing against the batch
+    PieceTable pieceTable(playfield, batched ? PieceTable::RenderMode::Batched : PieceTable::RenderMode::Instanced);
 
-    Piece JPiece(JpieceMap, 1.0f);
+    // Shared by both renderers, the projection only changes with the window size
+    GLState glState;
+    glState.SetProjectionMatrix(glm::ortho(0.0f, (float)screenWidth, 0.0f, (float)screenHeight));
 
-    // L
-    float LpieceMap[] = {
-        0.0f, 0.0f, 1.0f,
-        1.0f, 1.0f, 1.0f,
-        0.0f, 0.0f, 0.0f
-    };
+    // All programs are issued in one batch and built while the loader threads finish the font, warm starts load them
+    // from the program binary cache
+    ShaderManager shaderManager("shadercache", (GLADloadproc)glfwGetProcAddress);
+    Renderer::LoadShaders(shaderManager);
+    TextRenderer::LoadShaders(shaderManager);
+    BatchRenderer::LoadShaders(shaderManager);
+
+    if (!shaderManager.Finish())
+    {
+        glfwTerminate();
+        return -1;
+    }
 
-    Piece LPiece(LpieceMap, 2.0f);
+    assetLoader.Mark("shaders");
 
-    // O
-    float OpieceMap[] = {
-        1.0f, 1.0f, 0.0f,
-        1.0f, 1.0f, 0.0f,
-        0.0f, 0.0f, 0.0f
-    };
+    Renderer renderer(glState, shaderManager);
+    // Declared after the font, the renderers may hold a reference to its atlas until they are destroyed
+    TextRenderer textRenderer(glState, shaderManager);
+    BatchRenderer batchRenderer(glState, shaderManager);
 
-    Piece OPiece(OpieceMap, 3.0f);
+    uploadBatchRenderer = &batchRenderer;
+    assetLoader.Finish();
 
-    // S
-    float SpieceMap[] = {
-        0.0f, 1.0f, 1.0f,
-        1.0f, 1.0f, 0.0f,
-        0.0f, 0.0f, 0.0f
-    };
+    // The uploads bind textures behind the back of the state cache
+    glState.Invalidate();
 
-    Piece SPiece(SpieceMap, 4.0f);
+    assetLoader.Mark("assets");
 
-    // T
-    float TpieceMap[] = {
-        0.0f, 1.0f, 0.0f,
-        1.0f, 1.0f, 1.0f,
-        0.0f, 0.0f, 0.0f
-    };
+    NumericField linesField(glm::vec2(520.0f, 400.0f), 0.2f, 0, font);
 
-    Piece TPiece(TpieceMap, 5.0f);
+    std::cout << "assets font=" << (bakedFont ? "baked" : "fnt") << " texture_kb=" << (batched ? batchRenderer.GetTextureBytes() : font.GetTextureBytes()) / 1024 << std::endl;
 
-    // Z
-    float ZpieceMap[] = {
-        1.0f, 1.0f, 0.0f,
-        0.0f, 1.0f, 1.0f,
-        0.0f, 0.0f, 0.0f
-    };
+    if (benchmark)
+    {
+        assetLoader.PrintTimeline();
+        RunRenderBenchmark(window, glState, playfield, renderer, batchRenderer, benchmarkFrames);
+        glfwTerminate();
+        return 0;
+    }
 
-    Piece ZPiece(ZpieceMap, 6.0f);
+    Game game(seed);
+    Replay replay(seed);
+    bool recording = !recordPath.empty();
+    Bot bot;
 
-    //piece.Spawn(pieceTable, playfield);
+    FrameScheduler scheduler(frameSettings);
+    InputQueue inputQueue(inputSettings);
 
-    Renderer renderer;
+#ifdef TETRIS_PROFILE
+    if (!tracePath.empty())
+        Profiler::Get().BeginTrace(tracePath);
 
-    glm::mat4 projectionMatrix = glm::ortho(0.0f, (float)s_ScreenWidth, 0.0f, (float)s_ScreenHeight);
+    Profiler::Get().InitGpu();
+#endif
 
-    Font font("res/fonts/tahoma.fnt", "res/fonts/tahoma.png");
-    TextRenderer textRenderer(projectionMatrix);
+    // Window callbacks reach the scheduler and the input queue through the window user pointer
+    struct WindowCallbackTargets
+    {
+        FrameScheduler* Scheduler;
+        InputQueue* Input;
+    };
 
-    TextField textField(glm::vec2(520.0f, 400.0f), 0.2f, "0", font);
+    WindowCallbackTargets callbackTargets = { &scheduler, &inputQueue };
+    glfwSetWindowUserPointer(window, &callbackTargets);
 
-    //pieceTable.SetQuad(playfield, 56, 2);
-    //pieceTable.SetQuad(playfield, 78, 1);
-    //pieceTable.SetQuad(playfield, 156, 1);
-    //pieceTable.SetQuad(playfield, 179, 2);
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow* window)
+    {
+        ((WindowCallbackTargets*)glfwGetWindowUserPointer(window))->Scheduler->Invalidate();
+    });
 
-    bool pressedSpace = false;
-    bool pressedA = false;
-    bool pressedD = false;
+    glfwSetKeyCallback(window, [](GLFWwindow* window, int key, int, int action, int)
+    {
+        InputQueue::Action inputAction;
 
-    std::chrono::time_point<std::chrono::high_resolution_clock> m_StartTimepoint = std::chrono::high_resolution_clock::now();
-    auto start = std::chrono::time_point_cast<std::chrono::microseconds>(m_StartTimepoint).time_since_epoch().count();
+        switch (key)
+        {
+        case GLFW_KEY_A:        inputAction = InputQueue::ActionLeft; break;
+        case GLFW_KEY_D:        inputAction = InputQueue::ActionRight; break;
+        case GLFW_KEY_SPACE:    inputAction = InputQueue::ActionRotate; break;
+        case GLFW_KEY_S:        inputAction = InputQueue::ActionSoftDrop; break;
+        default:                return;
+        }
 
-    //pieceTable.SetQuad(playfield, 1, 1.0f);
+        // Events are dispatched as soon as the loop wakes up for them, so the dispatch time is the event time
+        if (action != GLFW_REPEAT)
+            ((WindowCallbackTargets*)glfwGetWindowUserPointer(window))->Input->Push(inputAction, action == GLFW_PRESS, glfwGetTime());
+    });
 
-    Piece* activePiece = &JPiece;
-    float speed = 500.0f;
+    uint64_t viewKey = 0;
+    bool startupReported = false;
 
-    srand(time(NULL));
+    // Simulation time advances in whole ticks, every tick consumes the input events that happened before its end
+    const double tickDuration = 1.0 / Game::TicksPerSecond;
+    const double maxCatchUp = Game::GravityTicks * tickDuration + 0.25;
+    double simulationTime = glfwGetTime();
 
-    uint32_t lines = 0;
+    // Startup calls do not count towards the per frame numbers
+    glState.ResetStats();
+    uint64_t reportedStreamedBytes = batchRenderer.GetStreamedBytes();
 
     while (!glfwWindowShouldClose(window))
     {
-        if (activePiece->IsLanded())
+        PROFILE_BEGIN_FRAME();
+
+        double time = glfwGetTime();
+
+        // Do not try to catch up after a long stall (window dragged, debugger break), the loop itself sleeps up to one gravity step
+        if (time - simulationTime > maxCatchUp)
+            simulationTime = time - maxCatchUp;
+
         {
-            for (uint32_t i = 0; i < 3; i++)
+            PROFILE_SCOPE("Simulation");
+
+            while (simulationTime + tickDuration <= time)
             {
-                uint32_t row = (activePiece->GetPosiion() / 10) + i + -1;
+                simulationTime += tickDuration;
+                uint8_t input = inputQueue.ConsumeTick(simulationTime, time);
 
-                if (row >= 20)
-                    continue;
+                if (useBot)
+                    input = bot.GetInput(game);
 
-                for (uint32_t j = 0; j < 10; j++)
-                {
-                    if (pieceTable.GetQuad(row * 10 + j) == 0)
-                        break;
+                if (recording)
+                    replay.Record(game.GetTick(), input);
+
+                game.Tick(input);
 
-                    if (j == 9)
+                if (game.IsGameOver())
+                {
+                    if (recording)
                     {
-                        pieceTable.Fall(playfield, row);
-                        lines++;
-                        textField.SetText(std::to_string(lines));
+                        replay.Finish(game);
+                        replay.Save(recordPath);
+                        recording = false;
                     }
+
+                    game.Reset(game.GetSeed() + 1);
                 }
             }
+        }
+
+        uint64_t previousViewKey = viewKey;
+        viewKey = GetViewKey(game);
 
-            uint32_t randomIndex = rand() % 6;
-            switch (randomIndex)
+        if (scheduler.ShouldRender(viewKey != previousViewKey))
+        {
+            linesField.SetValue(game.GetLines());
+
+            pieceTable.Update(game.GetBoard(), game.GetActivePiece());
+
+            renderer.Clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+            textRenderer.Submit(linesField);
+
+            if (batched)
             {
-            case 0:         activePiece = &JPiece; break;
-            case 1:         activePiece = &LPiece; break;
-            case 2:         activePiece = &OPiece; break;
-            case 3:         activePiece = &SPiece; break;
-            case 4:         activePiece = &TPiece; break;
-            case 5:         activePiece = &ZPiece; break;
+                // Text, border and cells end up in one draw per texture mode
+                textRenderer.Flush(batchRenderer, Renderer::HUDLayer);
+
+                renderer.SubmitPlayfield(batchRenderer, playfield, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+                renderer.SubmitPieceTable(batchRenderer, pieceTable);
+                batchRenderer.Flush();
             }
+            else
+            {
+                textRenderer.Flush();
 
-        activePiece->Respawn();
-        activePiece->Spawn(pieceTable, playfield);
+                renderer.RenderPlayfield(playfield, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+                pieceTable.Upload(glState);
+                renderer.RenderPieceTable(pieceTable);
+            }
 
-        }
+            {
+                PROFILE_SCOPE("glfwSwapBuffers");
+                glfwSwapBuffers(window);
+            }
 
+            scheduler.FrameRendered();
+            glState.FrameRendered();
 
-        if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && !pressedSpace)
-        {
-            activePiece->Rotate(pieceTable, playfield);
-            pressedSpace = true;
-        }
-        else if (glfwGetKey(window, GLFW_KEY_SPACE) != GLFW_PRESS)
-        {
-            pressedSpace = false;
+            // Startup ends with the first frame handed to the driver
+            if (!startupReported)
+            {
+                assetLoader.Mark("first frame");
+                assetLoader.PrintTimeline();
+                startupReported = true;
+            }
         }
 
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS && !pressedA)
-        {
-            activePiece->MoveLeft(pieceTable, playfield);
-            pressedA = true;
-        }
-        else if (glfwGetKey(window, GLFW_KEY_A) != GLFW_PRESS)
-        {
-            pressedA = false;
-        }
+        // Without input nothing happens before the next gravity step or auto repeat, the bot however plays every tick
+        double nextUpdateTime = simulationTime + game.GetTicksUntilGravity(inputQueue.GetHeldInput()) * tickDuration;
+
+        if (useBot || inputQueue.HasPendingEvents())
+            nextUpdateTime = simulationTime + tickDuration;
+        else if (inputQueue.GetNextRepeatTime() >= 0.0 && inputQueue.GetNextRepeatTime() < nextUpdateTime)
+            nextUpdateTime = simulationTime + (std::floor((inputQueue.GetNextRepeatTime() - simulationTime) / tickDuration) + 1.0) * tickDuration;
 
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS && !pressedD)
-        {
-            activePiece->MoveRight(pieceTable, playfield);
-            pressedD = true;
-        }
-        else if (glfwGetKey(window, GLFW_KEY_D) != GLFW_PRESS)
         {
-            pressedD = false;
+            // The key callbacks run from here, the zone includes the time spent waiting for an event
+            PROFILE_SCOPE("Input");
+            scheduler.Wait(nextUpdateTime - glfwGetTime());
         }
 
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-            speed = 75.0f;
-        else
-            speed = 500.0f;
-
-        auto endTimepoint = std::chrono::high_resolution_clock::now();
-        auto end = std::chrono::time_point_cast<std::chrono::microseconds>(endTimepoint).time_since_epoch().count();
-        auto duration = end - start;
-        double ms = duration * 0.001;
+        PROFILE_END_FRAME();
 
-        if (ms > speed)
+        if (scheduler.IsReportDue())
         {
-            activePiece->Move(pieceTable, playfield);
-            m_StartTimepoint = std::chrono::high_resolution_clock::now();
-            start = std::chrono::time_point_cast<std::chrono::microseconds>(m_StartTimepoint).time_since_epoch().count();
+            scheduler.Report();
+
+#ifdef TETRIS_PROFILE
+            Profiler::Get().PrintReport();
+#endif
+
+            const InputQueue::LatencyStats& latency = inputQueue.GetLatencyStats();
+            std::cout << "input presses=" << latency.Presses
+                      << " mean_latency_ms=" << (latency.Presses ? 1000.0 * latency.TotalLatency / latency.Presses : 0.0)
+                      << " max_latency_ms=" << 1000.0 * latency.MaxLatency << std::endl;
+
+            inputQueue.ResetLatencyStats();
+
+            const GLState::Stats& glStats = glState.GetStats();
+            std::cout << "gl calls_per_frame=" << (glStats.Frames ? (double)glStats.Issued / glStats.Frames : 0.0)
+                      << " elided_per_frame=" << (glStats.Frames ? (double)glStats.Elided / glStats.Frames : 0.0)
+                      << " draws_per_frame=" << (glStats.Frames ? (double)glStats.DrawCalls / glStats.Frames : 0.0) << std::endl;
+
+            // Board cells go through the piece table uploads with --direct and through the batch vertices otherwise
+            const PieceTable::UploadStats& uploadStats = pieceTable.GetUploadStats();
+            std::cout << "upload bytes_per_frame=" << (glStats.Frames ? (double)uploadStats.Bytes / glStats.Frames : 0.0)
+                      << " calls_per_frame=" << (glStats.Frames ? (double)uploadStats.Calls / glStats.Frames : 0.0)
+                      << " max_bytes=" << uploadStats.MaxBytes
+                      << " batch_bytes_per_frame=" << (glStats.Frames ? (double)(batchRenderer.GetStreamedBytes() - reportedStreamedBytes) / glStats.Frames : 0.0) << std::endl;
+
+            pieceTable.ResetUploadStats();
+            reportedStreamedBytes = batchRenderer.GetStreamedBytes();
+            glState.ResetStats();
         }
+    }
 
-
-        renderer.Clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
-
-        textRenderer.RenderTextField(textField);
-
-        renderer.RenderPlayfield(playfield, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-        renderer.RenderPieceTable(pieceTable);
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    if (recording)
+    {
+        replay.Finish(game);
+        replay.Save(recordPath);
     }
 
+#ifdef TETRIS_PROFILE
+    Profiler::Get().ShutdownGpu();
+    Profiler::Get().EndTrace();
+    Profiler::Get().PrintReport();
+#endif
+
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "AssetLoader.h"
+
+#include <iostream>
+
+AssetLoader::AssetLoader(uint32_t threadCount)
+    : m_StartTime(std::chrono::steady_clock::now()), m_MaxThreadCount(threadCount), m_LoadingAssetCount(0), m_Running(true)
+{
+    if (m_MaxThreadCount == 0)
+        m_MaxThreadCount = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+}
+
+AssetLoader::~AssetLoader()
+{
+    // Loads in progress run to completion, the ones not started yet are dropped
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+
+    m_LoadCondition.notify_all();
+
+    for (std::thread& thread : m_Threads)
+        thread.join();
+}
+
+void AssetLoader::Submit(const std::string& name, const LoadFunction& load, const UploadFunction& upload)
+{
+    m_Assets.emplace_back(new Asset());
+    Asset* asset = m_Assets.back().get();
+    asset->Name = name;
+    asset->Load = load;
+    asset->Upload = upload;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_PendingAssets.push_back(asset);
+        m_LoadingAssetCount++;
+    }
+
+    // A worker that would never get an asset is not worth its startup
+    if (m_Threads.size() < m_MaxThreadCount)
+        m_Threads.emplace_back(&AssetLoader::WorkerLoop, this, (uint32_t)m_Threads.size());
+
+    m_LoadCondition.notify_one();
+}
+
+void AssetLoader::Finish()
+{
+    while (true)
+    {
+        Asset* asset;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_CompletionCondition.wait(lock, [this]() { return !m_CompletedAssets.empty() || m_LoadingAssetCount == 0; });
+
+            if (m_CompletedAssets.empty())
+                return;
+
+            asset = m_CompletedAssets.front();
+            m_CompletedAssets.pop_front();
+        }
+
+        // Outside the lock, uploads can take a while and the workers keep completing assets meanwhile
+        Upload(*asset);
+    }
+}
+
+void AssetLoader::Mark(const std::string& milestone)
+{
+    m_Milestones.push_back({ milestone, GetTime() });
+}
+
+void AssetLoader::PrintTimeline() const
+{
+    for (const Milestone& milestone : m_Milestones)
+        std::cout << "startup at_ms=" << milestone.Time << " " << milestone.Name << std::endl;
+
+    // Assets not uploaded yet are still owned by the workers
+    for (const std::unique_ptr<Asset>& asset : m_Assets)
+    {
+        if (!asset->Uploaded)
+            continue;
+
+        std::cout << "startup asset=" << asset->Name << " loaded=" << asset->Loaded << " worker=" << asset->Worker
+                  << " load_at_ms=" << asset->LoadBegin << " load_ms=" << asset->LoadEnd - asset->LoadBegin
+                  << " upload_at_ms=" << asset->UploadBegin << " upload_ms=" << asset->UploadEnd - asset->UploadBegin << std::endl;
+    }
+}
+
+void AssetLoader::WorkerLoop(uint32_t worker)
+{
+    while (true)
+    {
+        Asset* asset;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_LoadCondition.wait(lock, [this]() { return !m_Running || !m_PendingAssets.empty(); });
+
+            if (!m_Running)
+                return;
+
+            asset = m_PendingAssets.front();
+            m_PendingAssets.pop_front();
+        }
+
+        asset->Worker = worker;
+        asset->LoadBegin = GetTime();
+        asset->Loaded = asset->Load();
+        asset->LoadEnd = GetTime();
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_CompletedAssets.push_back(asset);
+            m_LoadingAssetCount--;
+        }
+
+        m_CompletionCondition.notify_one();
+    }
+}
+
+void AssetLoader::Upload(Asset& asset)
+{
+    asset.UploadBegin = GetTime();
+    asset.Upload(asset.Loaded);
+    asset.UploadEnd = GetTime();
+    asset.Uploaded = true;
+}
+
+double AssetLoader::GetTime() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_StartTime).count();
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs the CPU side of loading assets (reading, parsing, decoding) on worker threads, so it overlaps with the window
+// and GL context creation on the main thread. Every asset has a load function run by a worker and an upload function
+// run by the main thread (with the context current) from Finish once the load is done.
+// Also keeps the startup timeline: asset timings plus milestones marked by the main thread
+class AssetLoader
+{
+public:
+    using LoadFunction = std::function<bool()>;
+    using UploadFunction = std::function<void(bool loaded)>;
+
+public:
+    // Workers are started as assets are submitted, at most one per asset and threadCount in total. 0 allows one worker
+    // per hardware thread besides the main thread
+    AssetLoader(uint32_t threadCount = 0);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+public:
+    void Submit(const std::string& name, const LoadFunction& load, const UploadFunction& upload);
+
+    // Waits for every submitted asset and uploads each one as soon as it is loaded
+    void Finish();
+
+    void Mark(const std::string& milestone);
+    void PrintTimeline() const;
+
+private:
+    struct Asset
+    {
+        std::string Name;
+        LoadFunction Load;
+        UploadFunction Upload;
+
+        bool Loaded = false;
+        bool Uploaded = false;
+        uint32_t Worker = 0;
+        // Milliseconds since the loader was created
+        double LoadBegin = 0.0;
+        double LoadEnd = 0.0;
+        double UploadBegin = 0.0;
+        double UploadEnd = 0.0;
+    };
+
+    struct Milestone
+    {
+        std::string Name;
+        double Time;
+    };
+
+    std::chrono::steady_clock::time_point m_StartTime;
+    std::vector<std::thread> m_Threads;
+    uint32_t m_MaxThreadCount;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_LoadCondition;
+    std::condition_variable m_CompletionCondition;
+    std::deque<Asset*> m_PendingAssets;         // waiting for a worker
+    std::deque<Asset*> m_CompletedAssets;       // loaded, waiting for the upload
+    uint32_t m_LoadingAssetCount;               // submitted and not completed yet
+    bool m_Running;
+
+    // Only touched by the main thread, the workers get pointers to the assets through the queues
+    std::vector<std::unique_ptr<Asset>> m_Assets;
+    std::vector<Milestone> m_Milestones;
+
+private:
+    void WorkerLoop(uint32_t worker);
+    void Upload(Asset& asset);
+    double GetTime() const;
+};
@@ -0,0 +1,429 @@
+#include "BatchRenderer.h"
+
+#include <iostream>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "Profiler.h"
+#include "TextRenderer.h"
+
+void BatchRenderer::LoadShaders(ShaderManager& shaderManager)
+{
+    shaderManager.Load("BatchRenderer.Solid", s_VertexShaderSource, s_SolidFragmentShaderSource);
+    shaderManager.Load("BatchRenderer.Color", s_VertexShaderSource, s_ColorFragmentShaderSource);
+    shaderManager.Load("BatchRenderer.Coverage", s_VertexShaderSource, s_CoverageFragmentShaderSource);
+    shaderManager.Load("BatchRenderer.DistanceField", s_VertexShaderSource, s_DistanceFieldFragmentShaderSource);
+}
+
+BatchRenderer::BatchRenderer(GLState& state, const ShaderManager& shaderManager)
+    : m_State(state), m_ShaderIDs(), m_OutlineColorUniformLocation(-1), m_OutlineWidthUniformLocation(-1), m_VertexArrayID(0), m_VertexBufferID(0),
+      m_IndexBufferID(0), m_StreamOffset(0), m_StreamedBytes(0), m_TextureBytes(0), m_OutlineColor(0.0f), m_OutlineWidth(0.0f)
+{
+    m_ShaderIDs[(uint32_t)TextureMode::Solid] = shaderManager.GetProgram("BatchRenderer.Solid");
+    m_ShaderIDs[(uint32_t)TextureMode::Color] = shaderManager.GetProgram("BatchRenderer.Color");
+    m_ShaderIDs[(uint32_t)TextureMode::Coverage] = shaderManager.GetProgram("BatchRenderer.Coverage");
+    m_ShaderIDs[(uint32_t)TextureMode::DistanceField] = shaderManager.GetProgram("BatchRenderer.DistanceField");
+
+    for (uint32_t mode = (uint32_t)TextureMode::Color; mode < (uint32_t)TextureMode::Count; mode++)
+    {
+        m_State.UseProgram(m_ShaderIDs[mode]);
+        m_State.SetUniform(glGetUniformLocation(m_ShaderIDs[mode], "u_Textures"), 0);
+    }
+
+    m_OutlineColorUniformLocation = glGetUniformLocation(m_ShaderIDs[(uint32_t)TextureMode::DistanceField], "u_OutlineColor");
+    m_OutlineWidthUniformLocation = glGetUniformLocation(m_ShaderIDs[(uint32_t)TextureMode::DistanceField], "u_OutlineWidth");
+
+    // Every draw starts at a vertex offset of the stream buffer, so one run of quad indices serves all of them
+    std::vector<uint16_t> indices(MaxDrawQuads * 6);
+    for (uint32_t i = 0; i < MaxDrawQuads; i++)
+    {
+        indices[i * 6 + 0] = 0 + 4 * i;
+        indices[i * 6 + 1] = 1 + 4 * i;
+        indices[i * 6 + 2] = 2 + 4 * i;
+        indices[i * 6 + 3] = 2 + 4 * i;
+        indices[i * 6 + 4] = 3 + 4 * i;
+        indices[i * 6 + 5] = 0 + 4 * i;
+    }
+
+    glGenBuffers(1, &m_VertexBufferID);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+    glBufferData(GL_ARRAY_BUFFER, StreamBufferQuads * 4 * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+
+    glGenVertexArrays(1, &m_VertexArrayID);
+    glBindVertexArray(m_VertexArrayID);
+
+    glGenBuffers(1, &m_IndexBufferID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, Position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, TexCoord));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const void*)offsetof(Vertex, Color));
+    glEnableVertexAttribArray(3);
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(Vertex), (const void*)offsetof(Vertex, TextureLayer));
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    // Bound behind the back of the state cache
+    m_State.Invalidate();
+}
+
+BatchRenderer::~BatchRenderer()
+{
+    for (const Page& page : m_Pages)
+    {
+        for (const TextureArray& textureArray : page.Arrays)
+            glDeleteTextures(1, &textureArray.ID);
+    }
+
+    glDeleteBuffers(1, &m_VertexBufferID);
+    glDeleteBuffers(1, &m_IndexBufferID);
+    glDeleteVertexArrays(1, &m_VertexArrayID);
+}
+
+BatchRenderer::Texture BatchRenderer::AddTexture(uint32_t width, uint32_t height, uint32_t channelCount, const uint8_t* texels, bool distanceField)
+{
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+
+    if (!texels || (channelCount != 1 && channelCount != 4) || width == 0 || height == 0 || width > (uint32_t)maxSize || height > (uint32_t)maxSize)
+    {
+        std::cout << "Failed to add a " << width << "x" << height << " texture with " << channelCount << " channels to the batch!" << std::endl;
+        return Texture();
+    }
+
+    TextureMode mode = channelCount == 4 ? TextureMode::Color : distanceField ? TextureMode::DistanceField : TextureMode::Coverage;
+
+    // The first page with a free layer large enough, the first texture of an array decides the size of its layers
+    uint32_t pageIndex = 0;
+    for (; pageIndex < m_Pages.size(); pageIndex++)
+    {
+        const TextureArray& textureArray = m_Pages[pageIndex].Arrays[(uint32_t)mode];
+
+        if (textureArray.LayerCount == 0 || (textureArray.LayerCount < MaxPageLayers && width <= textureArray.Width && height <= textureArray.Height))
+            break;
+    }
+
+    if (pageIndex > UINT16_MAX)
+    {
+        std::cout << "Out of batch texture pages!" << std::endl;
+        return Texture();
+    }
+
+    if (pageIndex == m_Pages.size())
+        m_Pages.emplace_back();
+
+    TextureArray& textureArray = m_Pages[pageIndex].Arrays[(uint32_t)mode];
+
+    if (textureArray.LayerCount == 0)
+    {
+        textureArray.Width = width;
+        textureArray.Height = height;
+    }
+
+    Texture texture;
+    texture.Page = pageIndex;
+    texture.Layer = textureArray.LayerCount;
+    texture.Mode = mode;
+    texture.TexCoordScale = glm::vec2((float)width / textureArray.Width, (float)height / textureArray.Height);
+
+    UploadLayer(textureArray, mode, width, height, texels);
+
+    return texture;
+}
+
+BatchRenderer::Texture BatchRenderer::GetFontTexture(const Font& font)
+{
+    for (const FontTexture& fontTexture : m_FontTextures)
+    {
+        if (fontTexture.TextureFont == &font)
+            return fontTexture.PageTexture;
+    }
+
+    Texture texture = AddTexture(font.GetTextureWidth(), font.GetTextureHeight(), font.GetTextureChannelCount(), font.GetTexels(), font.IsDistanceField());
+    m_FontTextures.push_back({ &font, texture });
+
+    return texture;
+}
+
+void BatchRenderer::UploadLayer(TextureArray& textureArray, TextureMode mode, uint32_t width, uint32_t height, const uint8_t* texels)
+{
+    uint32_t channelCount = mode == TextureMode::Color ? 4 : 1;
+    uint32_t rowBytes = textureArray.Width * channelCount;
+    uint32_t layerBytes = rowBytes * textureArray.Height;
+
+    GLenum internalFormat = channelCount == 1 ? GL_R8 : GL_RGBA8;
+    GLenum format = channelCount == 1 ? GL_RED : GL_RGBA;
+
+    // Rows of single channel textures are not 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    if (textureArray.LayerCount == textureArray.LayerCapacity)
+    {
+        uint32_t layerCapacity = std::min<uint32_t>(std::max<uint32_t>(textureArray.LayerCapacity * 2, 1), MaxPageLayers);
+        m_TextureBytes += (uint64_t)(layerCapacity - textureArray.LayerCapacity) * layerBytes;
+
+        uint32_t previousID = textureArray.ID;
+        glGenTextures(1, &textureArray.ID);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.ID);
+
+        // Coverage and color texels are looked up as they are, distances interpolate
+        GLint filter = mode == TextureMode::DistanceField ? GL_LINEAR : GL_NEAREST;
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat, textureArray.Width, textureArray.Height, layerCapacity, 0, format, GL_UNSIGNED_BYTE, nullptr);
+
+        if (previousID)
+        {
+            // Array textures can not grow, the filled layers go through a pixel buffer into the larger one without a
+            // trip to the CPU
+            uint32_t copyBufferID;
+            glGenBuffers(1, &copyBufferID);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, copyBufferID);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)textureArray.LayerCapacity * layerBytes, nullptr, GL_STREAM_COPY);
+
+            glBindTexture(GL_TEXTURE_2D_ARRAY, previousID);
+            glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, format, GL_UNSIGNED_BYTE, nullptr);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, copyBufferID);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.ID);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, textureArray.Width, textureArray.Height, textureArray.LayerCount, format, GL_UNSIGNED_BYTE, nullptr);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            glDeleteBuffers(1, &copyBufferID);
+            glDeleteTextures(1, &previousID);
+        }
+
+        textureArray.LayerCapacity = layerCapacity;
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.ID);
+
+    if (width == textureArray.Width && height == textureArray.Height)
+    {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, textureArray.LayerCount, width, height, 1, format, GL_UNSIGNED_BYTE, texels);
+    }
+    else
+    {
+        // Smaller textures sit in the bottom left corner of the layer, the rest is cleared through a staging copy that
+        // is gone once the upload returns
+        std::vector<uint8_t> layerTexels(layerBytes, 0);
+
+        for (uint32_t row = 0; row < height; row++)
+            std::memcpy(&layerTexels[row * rowBytes], &texels[row * width * channelCount], width * channelCount);
+
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, textureArray.LayerCount, textureArray.Width, textureArray.Height, 1, format, GL_UNSIGNED_BYTE, layerTexels.data());
+    }
+
+    textureArray.LayerCount++;
+
+    // Bound behind the back of the state cache, on whichever unit was active
+    m_State.Invalidate();
+}
+
+void BatchRenderer::Submit(uint8_t layer, const glm::vec2& corner0, const glm::vec2& corner1, uint32_t color)
+{
+    m_SortKeys.push_back(((uint64_t)layer << 56) | m_Quads.size());
+    m_Quads.push_back({ corner0, corner1, glm::vec2(0.0f), glm::vec2(0.0f), color, 0, 0, TextureMode::Solid });
+}
+
+void BatchRenderer::Submit(uint8_t layer, const glm::vec2& corner0, const glm::vec2& corner1, uint32_t color, const Texture& texture, const glm::vec2& texCoord0, const glm::vec2& texCoord1)
+{
+    m_SortKeys.push_back(((uint64_t)layer << 56) | ((uint64_t)texture.Mode << 48) | ((uint64_t)texture.Page << 32) | m_Quads.size());
+    m_Quads.push_back({ corner0, corner1, texCoord0 * texture.TexCoordScale, texCoord1 * texture.TexCoordScale, color, texture.Page, texture.Layer, texture.Mode });
+}
+
+void BatchRenderer::Flush()
+{
+    if (m_Quads.empty())
+        return;
+
+    PROFILE_GPU_SCOPE("BatchRenderer::Flush");
+
+    std::sort(m_SortKeys.begin(), m_SortKeys.end());
+
+    // Every quad is at depth 0, the layer order decides what ends up on top
+    m_State.SetDepthTest(false);
+    m_State.BindVertexArray(m_VertexArrayID);
+
+    TextureMode mode = m_Quads[(uint32_t)m_SortKeys.front()].Mode;
+    const Page* page = nullptr;
+
+    for (uint64_t sortKey : m_SortKeys)
+    {
+        const Quad& quad = m_Quads[(uint32_t)sortKey];
+
+        // Solid quads do not sample, consecutive ones share a draw whatever their layers
+        const Page* quadPage = quad.Mode != TextureMode::Solid ? &m_Pages[quad.Page] : nullptr;
+
+        if (quad.Mode != mode || quadPage != page || m_Vertices.size() == MaxDrawQuads * 4)
+        {
+            DrawVertices(mode, page);
+
+            mode = quad.Mode;
+            page = quadPage;
+        }
+
+        // Same corner order as the text quads, both triangles share the corner0 to corner1 diagonal
+        m_Vertices.push_back({ quad.Corner0, quad.TexCoord0, quad.Color, quad.TextureLayer });
+        m_Vertices.push_back({ glm::vec2(quad.Corner0.x, quad.Corner1.y), glm::vec2(quad.TexCoord0.x, quad.TexCoord1.y), quad.Color, quad.TextureLayer });
+        m_Vertices.push_back({ quad.Corner1, quad.TexCoord1, quad.Color, quad.TextureLayer });
+        m_Vertices.push_back({ glm::vec2(quad.Corner1.x, quad.Corner0.y), glm::vec2(quad.TexCoord1.x, quad.TexCoord0.y), quad.Color, quad.TextureLayer });
+    }
+
+    DrawVertices(mode, page);
+
+    // The capacity is kept for the next frame
+    m_Quads.clear();
+    m_SortKeys.clear();
+}
+
+void BatchRenderer::DrawVertices(TextureMode mode, const Page* page)
+{
+    if (m_Vertices.empty())
+        return;
+
+    m_State.UseProgram(m_ShaderIDs[(uint32_t)mode]);
+
+    if (page)
+        m_State.BindTextureArray(0, page->Arrays[(uint32_t)mode].ID);
+
+    if (mode == TextureMode::DistanceField)
+    {
+        m_State.SetUniform(m_OutlineColorUniformLocation, m_OutlineColor);
+        m_State.SetUniform(m_OutlineWidthUniformLocation, m_OutlineWidth);
+    }
+
+    uint32_t vertexCount = m_Vertices.size();
+
+    // Orphaning hands the old storage back to the driver while the GPU may still read it, no sync needed
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_VertexBufferID);
+    if (m_StreamOffset + vertexCount > StreamBufferQuads * 4)
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, StreamBufferQuads * 4 * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+        m_StreamOffset = 0;
+    }
+
+    glBufferSubData(GL_COPY_WRITE_BUFFER, m_StreamOffset * sizeof(Vertex), vertexCount * sizeof(Vertex), m_Vertices.data());
+    glDrawElementsBaseVertex(GL_TRIANGLES, vertexCount / 4 * 6, GL_UNSIGNED_SHORT, nullptr, m_StreamOffset);
+    m_State.CountDrawCall();
+
+    m_StreamOffset += vertexCount;
+    m_StreamedBytes += vertexCount * sizeof(Vertex);
+    m_Vertices.clear();
+}
+
+uint32_t BatchRenderer::PackColor(const glm::vec4& color)
+{
+    glm::u8vec4 packedColor = glm::u8vec4(glm::round(glm::clamp(color, 0.0f, 1.0f) * 255.0f));
+
+    uint32_t packed;
+    std::memcpy(&packed, &packedColor, sizeof(packed));
+
+    return packed;
+}
+
+
+const std::string BatchRenderer::s_VertexShaderSource =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) in vec4 position;\n"
+    "layout(location = 1) in vec2 texCoord;\n"
+    "layout(location = 2) in vec4 color;\n"
+    "layout(location = 3) in uint textureLayer;\n"
+    "\n"
+    "out vec2 v_TexCoord;\n"
+    "out vec4 v_Color;\n"
+    "flat out uint v_TextureLayer;\n"
+    "layout(std140) uniform Projection\n"
+    "{\n"
+    "   mat4 u_ProjectionMatrix;\n"
+    "};\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = u_ProjectionMatrix * position;\n"
+    "   v_TexCoord = texCoord;\n"
+    "   v_Color = color;\n"
+    "   v_TextureLayer = textureLayer;\n"
+    "}\n";
+
+const std::string BatchRenderer::s_SolidFragmentShaderSource =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) out vec4 color;\n"
+    "\n"
+    "in vec4 v_Color;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   color = v_Color;\n"
+    "}\n";
+
+const std::string BatchRenderer::s_ColorFragmentShaderSource =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) out vec4 color;\n"
+    "\n"
+    "in vec2 v_TexCoord;\n"
+    "in vec4 v_Color;\n"
+    "flat in uint v_TextureLayer;\n"
+    "uniform sampler2DArray u_Textures;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   color = texture(u_Textures, vec3(v_TexCoord, float(v_TextureLayer))) * v_Color;\n"
+    "}\n";
+
+const std::string BatchRenderer::s_CoverageFragmentShaderSource =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) out vec4 color;\n"
+    "\n"
+    "in vec2 v_TexCoord;\n"
+    "in vec4 v_Color;\n"
+    "flat in uint v_TextureLayer;\n"
+    "uniform sampler2DArray u_Textures;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   color = vec4(v_Color.rgb, v_Color.a * texture(u_Textures, vec3(v_TexCoord, float(v_TextureLayer))).r);\n"
+    "}\n";
+
+// Same edge and outline as the distance field text program
+const std::string BatchRenderer::s_DistanceFieldFragmentShaderSource =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) out vec4 color;\n"
+    "\n"
+    "in vec2 v_TexCoord;\n"
+    "in vec4 v_Color;\n"
+    "flat in uint v_TextureLayer;\n"
+    "uniform sampler2DArray u_Textures;\n"
+    "uniform vec4 u_OutlineColor;\n"
+    "uniform float u_OutlineWidth;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   float distance = texture(u_Textures, vec3(v_TexCoord, float(v_TextureLayer))).r;\n"
+    "   float smoothing = 0.5 * fwidth(distance);\n"
+    "\n"
+    "   float fill = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);\n"
+    "   float outline = smoothstep(0.5 - u_OutlineWidth - smoothing, 0.5 - u_OutlineWidth + smoothing, distance);\n"
+    "\n"
+    "   vec4 outlineColor = u_OutlineWidth > 0.0 ? u_OutlineColor : v_Color;\n"
+    "   color = mix(outlineColor, v_Color, fill);\n"
+    "   color.a *= outline;\n"
+    "}\n";
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+
+#include "GLState.h"
+#include "ShaderManager.h"
+
+class Font;
+
+// Collects the 2D quads of a frame from every part of the game (board lines, piece cells, text, later previews and
+// ghost pieces) and draws them with as few draw calls as it can. Every texture mode has its own program, so the
+// fragment shaders never branch on the quad. Textures are layers of texture arrays, one array per mode and page, so
+// quads with different textures still share a draw call as long as their textures are on the same page.
+// Quads are drawn in layer order (higher layers on top), sorted by mode and page within a layer and otherwise in the
+// order they were submitted. The vertices are streamed like the text ones, through a buffer orphaned when it wraps
+class BatchRenderer
+{
+public:
+    // 4 vertices per quad keep every draw addressable with 16 bit indices
+    static constexpr uint32_t MaxDrawQuads = 8192;
+    static constexpr uint32_t StreamBufferQuads = MaxDrawQuads * 2;
+    static constexpr uint32_t MaxPageLayers = 8;
+
+    // Program that draws a quad, the texture is multiplied by the quad color
+    enum class TextureMode : uint16_t
+    {
+        Solid,
+        // RGBA texel
+        Color,
+        // White with the R8 texel as alpha
+        Coverage,
+        // R8 distance to the outline (FontBaker --sdf), the edge is smoothed over one screen pixel
+        DistanceField,
+
+        Count
+    };
+
+    // Where AddTexture put a texture, the coordinates of the image are scaled into its part of the layer
+    struct Texture
+    {
+        uint16_t Page = 0;
+        uint16_t Layer = 0;
+        TextureMode Mode = TextureMode::Solid;
+        glm::vec2 TexCoordScale = glm::vec2(0.0f);
+    };
+
+public:
+    // Adds the batch program to the shader manager batch, it has to be finished before the renderer is created
+    static void LoadShaders(ShaderManager& shaderManager);
+
+    BatchRenderer(GLState& state, const ShaderManager& shaderManager);
+    ~BatchRenderer();
+
+    BatchRenderer(const BatchRenderer&) = delete;
+    BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+public:
+    // Copies the texels (bottom row first, 1 or 4 channels) into a layer of the page arrays, the textures live as long
+    // as the renderer. Single channel textures hold a coverage, or a distance when distanceField is set. A texture
+    // that can not be added comes back Solid, quads using it are drawn untextured
+    Texture AddTexture(uint32_t width, uint32_t height, uint32_t channelCount, const uint8_t* texels, bool distanceField = false);
+    // The atlas of a font, added on the first call. The font has to outlive the renderer
+    Texture GetFontTexture(const Font& font);
+
+    // Axis aligned quad between two opposite corners, color is RGBA8 (see PackColor). Textured quads map texCoord0 to
+    // corner0 and texCoord1 to corner1, in the 0..1 range of the image that was added
+    void Submit(uint8_t layer, const glm::vec2& corner0, const glm::vec2& corner1, uint32_t color);
+    void Submit(uint8_t layer, const glm::vec2& corner0, const glm::vec2& corner1, uint32_t color, const Texture& texture, const glm::vec2& texCoord0, const glm::vec2& texCoord1);
+
+    // Outline drawn around the distance field quads of the following flushes, the width is a distance as stored in the
+    // texels (0.5 is the whole range), 0 disables it
+    void SetOutline(const glm::vec4& color, float width) { m_OutlineColor = color; m_OutlineWidth = width; }
+
+    // Draws everything submitted since the last flush, the depth test is left disabled
+    void Flush();
+
+    static uint32_t PackColor(const glm::vec4& color);
+
+    // GPU memory of the texture arrays
+    uint64_t GetTextureBytes() const { return m_TextureBytes; }
+    // Vertex data sent to the stream buffer since the renderer was created
+    uint64_t GetStreamedBytes() const { return m_StreamedBytes; }
+
+private:
+    struct Vertex
+    {
+        glm::vec2 Position;
+        glm::vec2 TexCoord;
+        uint32_t Color;         // RGBA8
+        uint32_t TextureLayer;
+    };
+
+    struct Quad
+    {
+        glm::vec2 Corner0;
+        glm::vec2 Corner1;
+        glm::vec2 TexCoord0;
+        glm::vec2 TexCoord1;
+        uint32_t Color;
+        uint16_t Page;
+        uint16_t TextureLayer;
+        TextureMode Mode;
+    };
+
+    // Layers are allocated as they are needed, growing copies the filled layers on the GPU
+    struct TextureArray
+    {
+        uint32_t ID = 0;
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        uint32_t LayerCount = 0;
+        uint32_t LayerCapacity = 0;
+    };
+
+    // Indexed by TextureMode, Solid has no array
+    struct Page
+    {
+        TextureArray Arrays[(uint32_t)TextureMode::Count];
+    };
+
+    struct FontTexture
+    {
+        const Font* TextureFont;
+        Texture PageTexture;
+    };
+
+    GLState& m_State;
+
+    uint32_t m_ShaderIDs[(uint32_t)TextureMode::Count];
+    int m_OutlineColorUniformLocation;
+    int m_OutlineWidthUniformLocation;
+    uint32_t m_VertexArrayID;
+    uint32_t m_VertexBufferID;
+    uint32_t m_IndexBufferID;
+    uint32_t m_StreamOffset;        // in vertices
+    uint64_t m_StreamedBytes;
+
+    std::vector<Quad> m_Quads;
+    // Layer, mode, page and index of every quad, sorting them orders the quads without moving them
+    std::vector<uint64_t> m_SortKeys;
+    std::vector<Vertex> m_Vertices;
+
+    std::vector<Page> m_Pages;
+    std::vector<FontTexture> m_FontTextures;
+    uint64_t m_TextureBytes;
+
+    glm::vec4 m_OutlineColor;
+    float m_OutlineWidth;
+
+    static const std::string s_VertexShaderSource;
+    static const std::string s_SolidFragmentShaderSource;
+    static const std::string s_ColorFragmentShaderSource;
+    static const std::string s_CoverageFragmentShaderSource;
+    static const std::string s_DistanceFieldFragmentShaderSource;
+
+private:
+    void UploadLayer(TextureArray& textureArray, TextureMode mode, uint32_t width, uint32_t height, const uint8_t* texels);
+    // Draws the expanded vertices with the program of the mode and the array of the page and clears them
+    void DrawVertices(TextureMode mode, const Page* page);
+};
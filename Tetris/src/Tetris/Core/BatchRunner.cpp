@@ -0,0 +1,98 @@
+#include "BatchRunner.h"
+
+#include <chrono>
+
+#include "Game.h"
+
+BatchRunner::BatchRunner(uint32_t threadCount, size_t cacheBytes)
+    : m_Pool(threadCount)
+{
+    if (cacheBytes > 0)
+        m_Table.reset(new TranspositionTable(cacheBytes));
+
+    // Bots carry several kilobytes of search scratch space, one per worker is allocated once and reused
+    m_Bots.reserve(m_Pool.GetThreadCount());
+    for (uint32_t i = 0; i < m_Pool.GetThreadCount(); i++)
+    {
+        m_Bots.emplace_back(new Bot());
+        m_Bots.back()->SetTranspositionTable(m_Table.get());
+    }
+}
+
+const BatchSummary& BatchRunner::Run(uint64_t gameCount, uint64_t firstSeed, uint32_t maxPieces, const BotWeights& weights)
+{
+    for (std::unique_ptr<Bot>& bot : m_Bots)
+        bot->SetWeights(weights);
+
+    m_Results.resize(gameCount);
+    uint64_t steals = m_Pool.GetStealCount();
+    TranspositionTable::Stats cacheStats = m_Table ? m_Table->GetStats() : TranspositionTable::Stats();
+    auto startTimepoint = std::chrono::high_resolution_clock::now();
+
+    m_Pool.ParallelFor(gameCount, [&](uint64_t index, uint32_t worker)
+    {
+        PlayGame(*m_Bots[worker], firstSeed + index, maxPieces, m_Results[index]);
+    });
+
+    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - startTimepoint;
+
+    m_Summary = BatchSummary();
+    m_Summary.Games = gameCount;
+    m_Summary.Steals = m_Pool.GetStealCount() - steals;
+    m_Summary.Seconds = duration.count();
+
+    if (m_Table)
+    {
+        TranspositionTable::Stats stats = m_Table->GetStats();
+        m_Summary.CacheHits = stats.Hits - cacheStats.Hits;
+        m_Summary.CacheMisses = stats.Misses - cacheStats.Misses;
+        m_Summary.CacheEvictions = stats.Evictions - cacheStats.Evictions;
+    }
+
+    double milliseconds = 0.0;
+    for (const GameResult& result : m_Results)
+    {
+        m_Summary.Pieces += result.Pieces;
+        m_Summary.Lines += result.Lines;
+        m_Summary.Score += result.Score;
+        m_Summary.ToppedOut += result.ToppedOut;
+        milliseconds += result.Milliseconds;
+
+        if (result.Milliseconds > m_Summary.MaxMilliseconds)
+            m_Summary.MaxMilliseconds = result.Milliseconds;
+    }
+
+    if (gameCount > 0)
+    {
+        m_Summary.MeanPieces = (double)m_Summary.Pieces / gameCount;
+        m_Summary.MeanLines = (double)m_Summary.Lines / gameCount;
+        m_Summary.MeanScore = (double)m_Summary.Score / gameCount;
+        m_Summary.MeanMilliseconds = milliseconds / gameCount;
+    }
+
+    if (m_Summary.Seconds > 0.0)
+        m_Summary.GamesPerSecond = gameCount / m_Summary.Seconds;
+
+    return m_Summary;
+}
+
+void BatchRunner::PlayGame(Bot& bot, uint64_t seed, uint32_t maxPieces, GameResult& outResult)
+{
+    auto startTimepoint = std::chrono::high_resolution_clock::now();
+
+    Game game(seed);
+    bot.Reset();
+
+    while (!game.IsGameOver() && game.GetPieceCount() < maxPieces)
+        game.Tick(bot.GetInput(game));
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - startTimepoint;
+
+    outResult.Seed = seed;
+    outResult.Pieces = game.GetPieceCount();
+    outResult.Lines = game.GetLines();
+    outResult.Score = game.GetScore();
+    outResult.Ticks = game.GetTick();
+    outResult.Milliseconds = duration.count();
+    outResult.ToppedOut = game.IsGameOver();
+}
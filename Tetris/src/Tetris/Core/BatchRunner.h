@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Bot.h"
+#include "ThreadPool.h"
+#include "TranspositionTable.h"
+
+// Outcome of one headless bot game
+struct GameResult
+{
+    uint64_t Seed;
+    uint32_t Pieces;
+    uint32_t Lines;
+    uint32_t Score;
+    uint32_t Ticks;
+    double Milliseconds;
+    bool ToppedOut;
+};
+
+struct BatchSummary
+{
+    uint64_t Games = 0;
+    uint64_t Pieces = 0;
+    uint64_t Lines = 0;
+    uint64_t Score = 0;
+    uint64_t ToppedOut = 0;
+    uint64_t Steals = 0;
+
+    uint64_t CacheHits = 0;
+    uint64_t CacheMisses = 0;
+    uint64_t CacheEvictions = 0;
+
+    double MeanPieces = 0.0;
+    double MeanLines = 0.0;
+    double MeanScore = 0.0;
+    double MeanMilliseconds = 0.0;
+    double MaxMilliseconds = 0.0;
+
+    double Seconds = 0.0;
+    double GamesPerSecond = 0.0;
+};
+
+// Plays many independent bot games in parallel, game i uses seed firstSeed + i, so a batch gives the same results
+// whatever the thread count is. Every worker owns its own Bot, games share nothing but the result array and the
+// optional plan cache (which only ever returns what the search would have found)
+class BatchRunner
+{
+public:
+    // 0 uses one worker per hardware thread, cacheBytes bounds the shared plan cache, 0 disables it
+    BatchRunner(uint32_t threadCount = 0, size_t cacheBytes = 0);
+
+public:
+    // Games end on top out or after maxPieces pieces
+    const BatchSummary& Run(uint64_t gameCount, uint64_t firstSeed, uint32_t maxPieces, const BotWeights& weights = BotWeights());
+
+    const BatchSummary& GetSummary() const { return m_Summary; }
+    const std::vector<GameResult>& GetResults() const { return m_Results; }
+    uint32_t GetThreadCount() const { return m_Pool.GetThreadCount(); }
+    const TranspositionTable* GetTranspositionTable() const { return m_Table.get(); }
+
+private:
+    ThreadPool m_Pool;
+    std::unique_ptr<TranspositionTable> m_Table;
+    std::vector<std::unique_ptr<Bot>> m_Bots;
+    std::vector<GameResult> m_Results;
+    BatchSummary m_Summary;
+
+private:
+    static void PlayGame(Bot& bot, uint64_t seed, uint32_t maxPieces, GameResult& outResult);
+};
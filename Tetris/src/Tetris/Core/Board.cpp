@@ -0,0 +1,123 @@
+#include "Board.h"
+
+#include <cstring>
+
+#include "Random.h"
+
+struct ZobristKeys
+{
+    uint64_t Keys[Board::BufferRows + Board::Height][Board::Width];
+};
+
+static constexpr ZobristKeys GenerateZobristKeys()
+{
+    ZobristKeys keys = {};
+    Random random(0x5A0B0157ull);
+
+    for (int row = 0; row < Board::BufferRows + Board::Height; row++)
+    {
+        for (int column = 0; column < Board::Width; column++)
+            keys.Keys[row][column] = random.Next();
+    }
+
+    return keys;
+}
+
+// One random key per cell of the stored rows (floor rows never change and are left out)
+static constexpr ZobristKeys s_ZobristKeys = GenerateZobristKeys();
+
+Board::Board()
+{
+    Reset();
+}
+
+void Board::Reset()
+{
+    for (int i = 0; i < BufferRows + Height; i++)
+        m_Rows[i] = EmptyRow;
+
+    for (int i = BufferRows + Height; i < BufferRows + Height + FloorRows; i++)
+        m_Rows[i] = FullRow;
+
+    std::memset(m_Cells, 0, sizeof(m_Cells));
+    m_Hash = 0;
+}
+
+uint64_t Board::ComputeHash() const
+{
+    uint64_t hash = 0;
+
+    for (int row = 0; row < BufferRows + Height; row++)
+        hash ^= GetRowHash(row, m_Rows[row]);
+
+    return hash;
+}
+
+uint64_t Board::GetRowHash(int row, uint16_t rowBits)
+{
+    uint32_t cells = (rowBits >> Padding) & ((1u << Width) - 1);
+    uint64_t hash = 0;
+
+    for (int column = 0; cells; column++, cells >>= 1)
+    {
+        if (cells & 1)
+            hash ^= s_ZobristKeys.Keys[row][column];
+    }
+
+    return hash;
+}
+
+void Board::Place(const PieceMask& mask, int x, int y, uint8_t colorID)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        if (mask.Rows[i] == 0)
+            continue;
+
+        int row = y + i + BufferRows;
+        m_Rows[row] |= mask.Rows[i] << (x + Padding);
+
+        for (int j = 0; j < 4; j++)
+        {
+            if (mask.Rows[i] & (1 << j))
+            {
+                m_Cells[row * Width + x + j] = colorID;
+                m_Hash ^= s_ZobristKeys.Keys[row][x + j];
+            }
+        }
+    }
+}
+
+uint32_t Board::ClearLines()
+{
+    uint32_t clearedRows = 0;
+    int target = BufferRows + Height - 1;
+
+    for (int row = BufferRows + Height - 1; row >= 0; row--)
+    {
+        if (m_Rows[row] == FullRow && row >= BufferRows)
+        {
+            clearedRows |= 1u << (row - BufferRows);
+            m_Hash ^= GetRowHash(row, m_Rows[row]);
+            continue;
+        }
+
+        if (target != row)
+        {
+            // Moving a row only changes the keys of its cells, the rows it passes over were already removed
+            m_Hash ^= GetRowHash(row, m_Rows[row]) ^ GetRowHash(target, m_Rows[row]);
+            m_Rows[target] = m_Rows[row];
+            std::memcpy(&m_Cells[target * Width], &m_Cells[row * Width], Width);
+        }
+
+        target--;
+    }
+
+    for (; target >= 0; target--)
+    {
+        m_Rows[target] = EmptyRow;
+        std::memset(&m_Cells[target * Width], 0, Width);
+    }
+
+    return clearedRows;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+// Occupied cells of a piece inside its bounding box, one 4 bit mask per row (bit 0 = leftmost column)
+struct PieceMask
+{
+    uint16_t Rows[4];
+};
+
+class Board
+{
+public:
+    static constexpr int Width = 10;
+    static constexpr int Height = 20;
+
+    // Every row is stored as 16 bits: the playfield occupies bits [Padding, Padding + Width)
+    // and the bits on both sides are permanently set, so they act as walls during collision checks
+    static constexpr int Padding = 3;
+    static constexpr uint16_t FullRow = 0xFFFF;
+    static constexpr uint16_t EmptyRow = (uint16_t)~(((1u << Width) - 1) << Padding);
+
+    // Hidden rows above the playfield (pieces may rotate into them) and solid rows below it (floor)
+    static constexpr int BufferRows = 4;
+    static constexpr int FloorRows = 4;
+
+public:
+    Board();
+
+public:
+    void Reset();
+
+    // Bounding box positions Collides() can be asked about without reading outside of the stored rows
+    static constexpr bool IsInBounds(int x, int y) { return x >= -Padding && x < Width && y >= -BufferRows && y <= Height + FloorRows - 4; }
+
+    bool Collides(const PieceMask& mask, int x, int y) const
+    {
+        const uint16_t* rows = &m_Rows[y + BufferRows];
+        const uint32_t shift = x + Padding;
+
+        return ((rows[0] & (mask.Rows[0] << shift)) |
+                (rows[1] & (mask.Rows[1] << shift)) |
+                (rows[2] & (mask.Rows[2] << shift)) |
+                (rows[3] & (mask.Rows[3] << shift))) != 0;
+    }
+
+    void Place(const PieceMask& mask, int x, int y, uint8_t colorID);
+
+    bool IsRowFull(int row) const { return m_Rows[row + BufferRows] == FullRow; }
+
+    // Removes every full row and compacts the rest in a single sweep, bit N of the result is set when row N was cleared
+    uint32_t ClearLines();
+
+    uint16_t GetRow(int row) const { return m_Rows[row + BufferRows]; }
+    uint8_t GetCell(uint32_t index) const { return m_Cells[BufferRows * Width + index]; }
+    uint8_t GetCell(int x, int y) const { return m_Cells[(y + BufferRows) * Width + x]; }
+    // Color IDs of the visible playfield, Width * Height entries starting at the top left cell
+    const uint8_t* GetCells() const { return &m_Cells[BufferRows * Width]; }
+
+    // Zobrist hash of the occupied cells (colors are ignored), kept up to date by Place and ClearLines
+    uint64_t GetHash() const { return m_Hash; }
+    // Same hash computed from scratch
+    uint64_t ComputeHash() const;
+
+private:
+    uint16_t m_Rows[BufferRows + Height + FloorRows];
+    uint8_t m_Cells[(BufferRows + Height) * Width];
+    uint64_t m_Hash;
+
+private:
+    // Hash contribution of the cells of rowBits stored at storage row `row`
+    static uint64_t GetRowHash(int row, uint16_t rowBits);
+};
@@ -0,0 +1,358 @@
+#include "Bot.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "Random.h"
+
+Bot::Bot(const BotWeights& weights)
+    : m_WeightsKey(0), m_Table(nullptr), m_Path(), m_PathStates(), m_PathLength(0), m_PathStep(0), m_HasPlan(false), m_PlannedPieceCount(0),
+      m_SearchCount(0)
+{
+    SetWeights(weights);
+}
+
+void Bot::SetWeights(const BotWeights& weights)
+{
+    m_Weights = weights;
+
+    // Plans depend on the weights, so they are part of the cache key
+    uint32_t bits[sizeof(BotWeights) / sizeof(uint32_t)];
+    std::memcpy(bits, &m_Weights, sizeof(bits));
+
+    m_WeightsKey = 0;
+    for (uint32_t i = 0; i < sizeof(bits) / sizeof(bits[0]); i++)
+        m_WeightsKey = Random(m_WeightsKey ^ bits[i]).Next();
+}
+
+void Bot::Reset()
+{
+    // GetInput looks at the first path state before it finds out there is no plan
+    std::memset(m_PathStates, 0, sizeof(m_PathStates));
+    m_PathLength = 0;
+    m_PathStep = 0;
+    m_HasPlan = false;
+    m_PlannedPieceCount = 0;
+}
+
+uint8_t Bot::GetInput(const Game& game)
+{
+    if (game.IsGameOver())
+        return 0;
+
+    const Piece& piece = game.GetActivePiece();
+    uint32_t stateIndex = GetStateIndex(piece);
+
+    // Gravity may have moved the piece since the last tick, follow the plan from wherever the piece is now
+    uint32_t step = m_PathStep;
+    while (step <= m_PathLength && m_PathStates[step] != stateIndex)
+        step++;
+
+    if (!m_HasPlan || game.GetPieceCount() != m_PlannedPieceCount || step > m_PathLength)
+    {
+        Plan(game.GetBoard(), piece);
+        m_PlannedPieceCount = game.GetPieceCount();
+        step = 0;
+    }
+
+    m_PathStep = step;
+
+    // At the target (or waiting for gravity on a down step) the soft drop brings the piece down
+    if (m_PathStep == m_PathLength || m_Path[m_PathStep] == MoveDown)
+        return Game::InputSoftDrop;
+
+    switch (m_Path[m_PathStep])
+    {
+    case MoveLeft:                      return Game::InputLeft;
+    case MoveRight:                     return Game::InputRight;
+    case MoveRotate:                    return Game::InputRotate;
+    case MoveRotateCounterClockwise:    return Game::InputRotateCounterClockwise;
+    default:                            return Game::InputSoftDrop;
+    }
+}
+
+uint32_t Bot::FindPlacements(const Board& board, const Piece& piece, Placement* outPlacements)
+{
+    TetrominoType type = piece.GetType();
+    uint32_t placementCount = 0;
+
+    // Distinct placements are told apart by the cells they cover, several rotation states of I, S, Z and O
+    // cover the same cells at different positions
+    uint64_t footprints[MaxPlacements];
+    int footprintRows[MaxPlacements];
+
+    std::memset(m_Visited, 0, sizeof(m_Visited));
+
+    uint16_t queue[StateCount];
+    uint32_t queueBegin = 0;
+    uint32_t queueEnd = 0;
+
+    uint32_t startIndex = GetStateIndex(piece);
+    m_Visited[startIndex] = 1;
+    m_States[startIndex] = { (uint16_t)startIndex, MoveDown };
+    queue[queueEnd++] = startIndex;
+
+    while (queueBegin < queueEnd)
+    {
+        uint32_t stateIndex = queue[queueBegin++];
+        Piece state = GetStatePiece(type, stateIndex);
+
+        for (uint32_t move = MoveLeft; move <= MoveDown; move++)
+        {
+            Piece next = state;
+
+            if (!ApplyMove(next, board, (Move)move))
+            {
+                if (move != MoveDown || placementCount == MaxPlacements)
+                    continue;
+
+                // The piece can not fall any further, this state is a final placement
+                const PieceMask& mask = state.GetMask();
+                uint64_t footprint = 0;
+                int firstRow = -1;
+
+                for (int i = 0; i < 4; i++)
+                {
+                    if (mask.Rows[i] == 0)
+                        continue;
+
+                    if (firstRow < 0)
+                        firstRow = i;
+
+                    footprint |= (uint64_t)(mask.Rows[i] << (state.GetX() + Board::Padding)) << ((i - firstRow) * 16);
+                }
+
+                firstRow += state.GetY();
+
+                bool duplicate = false;
+                for (uint32_t i = 0; i < placementCount && !duplicate; i++)
+                    duplicate = footprints[i] == footprint && footprintRows[i] == firstRow;
+
+                if (duplicate)
+                    continue;
+
+                footprints[placementCount] = footprint;
+                footprintRows[placementCount] = firstRow;
+                outPlacements[placementCount++] = { (int8_t)state.GetX(), (int8_t)state.GetY(), (uint8_t)state.GetRotation(), (uint16_t)stateIndex, 0.0f };
+                continue;
+            }
+
+            uint32_t nextIndex = GetStateIndex(next);
+
+            if (m_Visited[nextIndex])
+                continue;
+
+            m_Visited[nextIndex] = 1;
+            m_States[nextIndex] = { (uint16_t)stateIndex, (Move)move };
+            queue[queueEnd++] = nextIndex;
+        }
+    }
+
+    m_SearchCount++;
+    return placementCount;
+}
+
+uint32_t Bot::ChoosePlacement(const Board& board, TetrominoType type, Placement* placements, uint32_t placementCount) const
+{
+    uint32_t bestIndex = 0;
+
+    uint16_t boardRows[Board::Height];
+    for (int row = 0; row < Board::Height; row++)
+        boardRows[row] = board.GetRow(row);
+
+    // Candidate boards are built into batches and evaluated a whole batch at a time by the SIMD kernel
+    BoardBatch batch = {};
+    BoardFeatures features[BoardBatch::Size];
+    int lines[BoardBatch::Size];
+    bool aboveBoard[BoardBatch::Size];
+
+    for (uint32_t first = 0; first < placementCount; first += BoardBatch::Size)
+    {
+        uint32_t batchCount = placementCount - first < BoardBatch::Size ? placementCount - first : BoardBatch::Size;
+
+        for (uint32_t lane = 0; lane < batchCount; lane++)
+        {
+            const Placement& placement = placements[first + lane];
+            const PieceMask& mask = Tetromino::GetMask(type, placement.Rotation);
+
+            uint16_t rows[Board::Height];
+            for (int row = 0; row < Board::Height; row++)
+                rows[row] = boardRows[row];
+
+            aboveBoard[lane] = false;
+
+            for (int j = 0; j < 4; j++)
+            {
+                if (mask.Rows[j] == 0)
+                    continue;
+
+                int row = placement.Y + j;
+
+                if (row < 0)
+                    aboveBoard[lane] = true;
+                else
+                    rows[row] |= mask.Rows[j] << (placement.X + Board::Padding);
+            }
+
+            // Same compaction as Board::ClearLines, on the row masks only
+            lines[lane] = 0;
+            int target = Board::Height - 1;
+
+            for (int row = Board::Height - 1; row >= 0; row--)
+            {
+                if (rows[row] == Board::FullRow)
+                    lines[lane]++;
+                else
+                    batch.Rows[target--][lane] = rows[row];
+            }
+
+            for (; target >= 0; target--)
+                batch.Rows[target][lane] = Board::EmptyRow;
+        }
+
+        ComputeFeatures(batch, batchCount, features);
+
+        for (uint32_t lane = 0; lane < batchCount; lane++)
+        {
+            Placement& placement = placements[first + lane];
+
+            placement.Score = m_Weights.AggregateHeight * features[lane].AggregateHeight +
+                              m_Weights.Holes * features[lane].Holes +
+                              m_Weights.Bumpiness * features[lane].Bumpiness +
+                              m_Weights.WellDepth * features[lane].WellDepth +
+                              m_Weights.RowTransitions * features[lane].RowTransitions +
+                              m_Weights.ColumnTransitions * features[lane].ColumnTransitions +
+                              m_Weights.Lines * lines[lane];
+
+            // Treat locking a cell above the board as losing, even though the game only ends when the next spawn collides
+            if (aboveBoard[lane] && lines[lane] == 0)
+                placement.Score = -1e9f;
+
+            if (placement.Score > placements[bestIndex].Score)
+                bestIndex = first + lane;
+        }
+    }
+
+    return bestIndex;
+}
+
+void Bot::Plan(const Board& board, const Piece& piece)
+{
+    uint32_t startIndex = GetStateIndex(piece);
+
+    m_PathStates[0] = startIndex;
+    m_PathLength = 0;
+    m_PathStep = 0;
+    m_HasPlan = true;
+
+    uint64_t key = 0;
+    if (m_Table)
+    {
+        uint64_t data[TranspositionTable::DataWords];
+        key = GetCacheKey(board, piece);
+
+        if (m_Table->Probe(key, data) && LoadCachedPlan(board, piece, data))
+            return;
+    }
+
+    uint32_t placementCount = FindPlacements(board, piece, m_Placements);
+
+    if (placementCount == 0)
+        return;
+
+    uint32_t bestIndex = ChoosePlacement(board, piece.GetType(), m_Placements, placementCount);
+
+    // Walk the search tree back from the target, then reverse the moves into the path
+    uint32_t length = 0;
+
+    for (uint32_t index = m_Placements[bestIndex].StateIndex; index != startIndex; index = m_States[index].Parent)
+    {
+        // Every state has one parent and the tree is rooted at the start, the walk can not outgrow the path
+        assert(length < MaxPathLength);
+
+        m_Path[length] = m_States[index].LastMove;
+        m_PathStates[length + 1] = index;
+        length++;
+    }
+
+    for (uint32_t i = 0; i < length / 2; i++)
+    {
+        Move move = m_Path[i];
+        m_Path[i] = m_Path[length - 1 - i];
+        m_Path[length - 1 - i] = move;
+
+        uint16_t state = m_PathStates[i + 1];
+        m_PathStates[i + 1] = m_PathStates[length - i];
+        m_PathStates[length - i] = state;
+    }
+
+    m_PathLength = length;
+
+    if (m_Table && m_PathLength <= MaxCachedPathLength)
+        StoreCachedPlan(key);
+}
+
+uint64_t Bot::GetCacheKey(const Board& board, const Piece& piece) const
+{
+    uint64_t pieceKey = ((uint64_t)piece.GetType() << 16) | GetStateIndex(piece);
+    uint64_t key = board.GetHash() ^ Random(pieceKey ^ m_WeightsKey).Next();
+
+    return key != 0 ? key : 1;
+}
+
+bool Bot::LoadCachedPlan(const Board& board, const Piece& piece, const uint64_t* data)
+{
+    uint32_t length = data[0] & 0xFF;
+    if (length > MaxCachedPathLength)
+        return false;
+
+    Piece state = piece;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        uint32_t bit = 8 + i * 4;
+        Move move = (Move)((data[bit / 64] >> (bit % 64)) & 0xF);
+
+        if (move > MoveDown || !ApplyMove(state, board, move))
+            return false;
+
+        m_Path[i] = move;
+        m_PathStates[i + 1] = GetStateIndex(state);
+    }
+
+    m_PathLength = length;
+    return true;
+}
+
+void Bot::StoreCachedPlan(uint64_t key) const
+{
+    uint64_t data[TranspositionTable::DataWords] = {};
+    data[0] = m_PathLength;
+
+    for (uint32_t i = 0; i < m_PathLength; i++)
+    {
+        uint32_t bit = 8 + i * 4;
+        data[bit / 64] |= (uint64_t)m_Path[i] << (bit % 64);
+    }
+
+    m_Table->Store(key, data);
+}
+
+bool Bot::ApplyMove(Piece& piece, const Board& board, Move move)
+{
+    switch (move)
+    {
+    case MoveLeft:                      return piece.MoveLeft(board);
+    case MoveRight:                     return piece.MoveRight(board);
+    case MoveRotate:                    return piece.Rotate(board);
+    case MoveRotateCounterClockwise:    return piece.RotateCounterClockwise(board);
+    case MoveDown:                      return piece.Move(board);
+    default:                            return false;
+    }
+}
+
+Piece Bot::GetStatePiece(TetrominoType type, uint32_t stateIndex)
+{
+    uint32_t position = stateIndex / 4;
+    return Piece(type, (int)(position % XCount) + MinX, (int)(position / XCount) + MinY, stateIndex % 4);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Board.h"
+#include "Evaluator.h"
+#include "Game.h"
+#include "Piece.h"
+#include "TranspositionTable.h"
+
+// Weights of the placement heuristic, a placement scores the weighted sum of the features of the board it leaves
+struct BotWeights
+{
+    float AggregateHeight = -0.51f;
+    float Holes = -0.36f;
+    float Bumpiness = -0.18f;
+    float WellDepth = -0.05f;
+    float RowTransitions = 0.0f;
+    float ColumnTransitions = 0.0f;
+    float Lines = 0.76f;
+};
+
+// Plays a Game through the same per tick inputs as the keyboard. For every new piece it enumerates all reachable
+// final placements with a breadth first search over position and rotation (slides and kicked spins included),
+// scores them and then steers the piece along the shortest path to the best one
+class Bot
+{
+public:
+    // Upper bound of distinct final placements of one piece
+    static constexpr uint32_t MaxPlacements = 256;
+
+    enum Move : uint8_t
+    {
+        MoveLeft,
+        MoveRight,
+        MoveRotate,
+        MoveRotateCounterClockwise,
+        MoveDown
+    };
+
+    struct Placement
+    {
+        int8_t X;
+        int8_t Y;
+        uint8_t Rotation;
+        uint16_t StateIndex;
+        float Score;
+    };
+
+public:
+    Bot(const BotWeights& weights = BotWeights());
+
+public:
+    // Forgets the current plan, needed when the bot moves on to a new game
+    void Reset();
+
+    // Input for the next Game::Tick
+    uint8_t GetInput(const Game& game);
+
+    // Fills outPlacements with every distinct final placement reachable from piece, returns their count
+    uint32_t FindPlacements(const Board& board, const Piece& piece, Placement* outPlacements);
+    // Scores the placements and returns the index of the best one
+    uint32_t ChoosePlacement(const Board& board, TetrominoType type, Placement* placements, uint32_t placementCount) const;
+
+    const BotWeights& GetWeights() const { return m_Weights; }
+    void SetWeights(const BotWeights& weights);
+
+    // Plans are looked up in and stored to the table (keyed by board, piece state and weights), which may be shared
+    // with bots on other threads. nullptr disables the cache
+    void SetTranspositionTable(TranspositionTable* table) { m_Table = table; }
+
+    uint64_t GetSearchCount() const { return m_SearchCount; }
+
+private:
+    static constexpr int MinX = -Board::Padding;
+    static constexpr int XCount = Board::Width + Board::Padding;
+    static constexpr int MinY = -Board::BufferRows;
+    static constexpr int YCount = Board::Height + Board::BufferRows + 1;
+    static constexpr uint32_t StateCount = XCount * YCount * 4;
+    // A path follows the search tree from the target back to the start, it visits every state at most once
+    static constexpr uint32_t MaxPathLength = StateCount - 1;
+    // A cached plan is its length in the low byte and 4 bits per move after it
+    static constexpr uint32_t MaxCachedPathLength = (TranspositionTable::DataWords * 64 - 8) / 4;
+
+    struct SearchState
+    {
+        uint16_t Parent;
+        Move LastMove;
+    };
+
+    BotWeights m_Weights;
+    uint64_t m_WeightsKey;
+    TranspositionTable* m_Table;
+
+    // Search scratch space, kept in the bot so that planning never allocates
+    SearchState m_States[StateCount];
+    uint8_t m_Visited[StateCount];
+    Placement m_Placements[MaxPlacements];
+
+    // Plan of the current piece, m_Path[i] leads from state m_PathStates[i] to state m_PathStates[i + 1]
+    Move m_Path[MaxPathLength];
+    uint16_t m_PathStates[MaxPathLength + 1];
+    uint32_t m_PathLength;
+    uint32_t m_PathStep;
+    bool m_HasPlan;
+
+    uint32_t m_PlannedPieceCount;
+    uint64_t m_SearchCount;
+
+private:
+    void Plan(const Board& board, const Piece& piece);
+
+    uint64_t GetCacheKey(const Board& board, const Piece& piece) const;
+    // Rebuilds the path and its states by replaying the cached moves, false if any of them does not apply
+    bool LoadCachedPlan(const Board& board, const Piece& piece, const uint64_t* data);
+    void StoreCachedPlan(uint64_t key) const;
+
+    static bool ApplyMove(Piece& piece, const Board& board, Move move);
+
+    static uint32_t GetStateIndex(int x, int y, uint32_t rotation) { return ((y - MinY) * XCount + (x - MinX)) * 4 + rotation; }
+    static uint32_t GetStateIndex(const Piece& piece) { return GetStateIndex(piece.GetX(), piece.GetY(), piece.GetRotation()); }
+    static Piece GetStatePiece(TetrominoType type, uint32_t stateIndex);
+};
@@ -0,0 +1,324 @@
+#include "Evaluator.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define EVALUATOR_X86 1
+    #include <immintrin.h>
+
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define EVALUATOR_TARGET(name)
+    #else
+        #define EVALUATOR_TARGET(name) __attribute__((target(name)))
+    #endif
+#else
+    #define EVALUATOR_X86 0
+#endif
+
+// Every feature is a sum over the rows, walking from the top row down with `covered` holding the union of the rows
+// seen so far (a column is covered from its highest filled cell down). Since coverage only grows downwards:
+//  - a column adds one to its height for every covered row, so AggregateHeight is the covered cell count
+//  - |h[c] - h[c + 1]| is the number of rows in which exactly one of the two columns is covered
+//  - a well cell is an uncovered cell with both neighbours covered (walls are always covered)
+// which turns the whole evaluation into shifts, masks and popcounts that work the same on one board or on a lane
+static constexpr uint32_t PlayfieldMask = ((1u << Board::Width) - 1) << Board::Padding;
+static constexpr uint32_t BumpinessMask = ((1u << (Board::Width - 1)) - 1) << Board::Padding;
+static constexpr uint32_t RowTransitionMask = ((1u << (Board::Width + 1)) - 1) << (Board::Padding - 1);
+
+// Popcount of a 16 bit row, done in registers since without a hardware popcount std::bitset ends up in a library call
+static int32_t CountBits(uint32_t value)
+{
+    value = value - ((value >> 1) & 0x5555);
+    value = (value & 0x3333) + ((value >> 2) & 0x3333);
+    value = (value + (value >> 4)) & 0x0F0F;
+    return (int32_t)((value + (value >> 8)) & 0x1F);
+}
+
+void ComputeFeatures(const uint16_t* rows, BoardFeatures& outFeatures)
+{
+    BoardFeatures features = {};
+
+    uint32_t covered = Board::EmptyRow;
+    uint32_t previous = Board::EmptyRow;
+
+    for (int i = 0; i < Board::Height; i++)
+    {
+        uint32_t row = rows[i];
+
+        features.Holes += CountBits(covered & ~row & PlayfieldMask);
+        features.ColumnTransitions += CountBits((row ^ previous) & PlayfieldMask);
+        features.RowTransitions += CountBits((row ^ (row >> 1)) & RowTransitionMask);
+
+        covered |= row;
+
+        features.AggregateHeight += CountBits(covered & PlayfieldMask);
+        features.MaxHeight += (covered & PlayfieldMask) != 0;
+        features.Bumpiness += CountBits((covered ^ (covered >> 1)) & BumpinessMask);
+        features.WellDepth += CountBits(~covered & (covered << 1) & (covered >> 1) & PlayfieldMask);
+
+        previous = row;
+    }
+
+    features.ColumnTransitions += CountBits(~previous & PlayfieldMask);
+
+    outFeatures = features;
+}
+
+// Feature sums of every lane, popcounts are accumulated per byte (at most 8 * Height, fits) and folded at the end
+struct BatchSums
+{
+    uint16_t AggregateHeight[BoardBatch::Size];
+    uint16_t EmptyRows[BoardBatch::Size];
+    uint16_t Holes[BoardBatch::Size];
+    uint16_t Bumpiness[BoardBatch::Size];
+    uint16_t WellDepth[BoardBatch::Size];
+    uint16_t RowTransitions[BoardBatch::Size];
+    uint16_t ColumnTransitions[BoardBatch::Size];
+};
+
+static_assert(8 * Board::Height <= 255, "Per byte popcount sums must fit in 8 bits");
+
+static void StoreFeatures(const BatchSums& sums, uint32_t boardCount, BoardFeatures* outFeatures)
+{
+    for (uint32_t i = 0; i < boardCount; i++)
+    {
+        BoardFeatures& features = outFeatures[i];
+        features.AggregateHeight = sums.AggregateHeight[i];
+        features.MaxHeight = Board::Height - sums.EmptyRows[i];
+        features.Holes = sums.Holes[i];
+        features.Bumpiness = sums.Bumpiness[i];
+        features.WellDepth = sums.WellDepth[i];
+        features.RowTransitions = sums.RowTransitions[i];
+        features.ColumnTransitions = sums.ColumnTransitions[i];
+    }
+}
+
+static void ComputeFeaturesScalar(const BoardBatch& batch, uint32_t boardCount, BoardFeatures* outFeatures)
+{
+    for (uint32_t lane = 0; lane < boardCount; lane++)
+    {
+        uint16_t rows[Board::Height];
+        for (int row = 0; row < Board::Height; row++)
+            rows[row] = batch.Rows[row][lane];
+
+        ComputeFeatures(rows, outFeatures[lane]);
+    }
+}
+
+#if EVALUATOR_X86
+
+EVALUATOR_TARGET("sse4.2")
+static __m128i CountBytes128(__m128i value)
+{
+    const __m128i lookup = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m128i lowNibbles = _mm_set1_epi8(0x0F);
+
+    __m128i low = _mm_and_si128(value, lowNibbles);
+    __m128i high = _mm_and_si128(_mm_srli_epi16(value, 4), lowNibbles);
+    return _mm_add_epi8(_mm_shuffle_epi8(lookup, low), _mm_shuffle_epi8(lookup, high));
+}
+
+EVALUATOR_TARGET("sse4.2")
+static void StoreSums128(__m128i byteSums, uint16_t* outSums)
+{
+    __m128i sums = _mm_add_epi16(_mm_and_si128(byteSums, _mm_set1_epi16(0x00FF)), _mm_srli_epi16(byteSums, 8));
+    _mm_storeu_si128((__m128i*)outSums, sums);
+}
+
+EVALUATOR_TARGET("sse4.2")
+static void ComputeFeaturesSSE42(const BoardBatch& batch, uint32_t boardCount, BoardFeatures* outFeatures)
+{
+    const __m128i playfieldMask = _mm_set1_epi16((int16_t)PlayfieldMask);
+    const __m128i bumpinessMask = _mm_set1_epi16((int16_t)BumpinessMask);
+    const __m128i rowTransitionMask = _mm_set1_epi16((int16_t)RowTransitionMask);
+    const __m128i zero = _mm_setzero_si128();
+
+    BatchSums sums;
+
+    for (uint32_t offset = 0; offset < BoardBatch::Size && offset < boardCount; offset += 8)
+    {
+        __m128i covered = _mm_set1_epi16((int16_t)Board::EmptyRow);
+        __m128i previous = covered;
+
+        __m128i aggregateHeight = zero, emptyRows = zero, holes = zero, bumpiness = zero;
+        __m128i wellDepth = zero, rowTransitions = zero, columnTransitions = zero;
+
+        for (int i = 0; i < Board::Height; i++)
+        {
+            __m128i row = _mm_load_si128((const __m128i*)&batch.Rows[i][offset]);
+
+            holes = _mm_add_epi8(holes, CountBytes128(_mm_andnot_si128(row, _mm_and_si128(covered, playfieldMask))));
+            columnTransitions = _mm_add_epi8(columnTransitions, CountBytes128(_mm_and_si128(_mm_xor_si128(row, previous), playfieldMask)));
+            rowTransitions = _mm_add_epi8(rowTransitions, CountBytes128(_mm_and_si128(_mm_xor_si128(row, _mm_srli_epi16(row, 1)), rowTransitionMask)));
+
+            covered = _mm_or_si128(covered, row);
+            __m128i coveredCells = _mm_and_si128(covered, playfieldMask);
+
+            aggregateHeight = _mm_add_epi8(aggregateHeight, CountBytes128(coveredCells));
+            emptyRows = _mm_sub_epi16(emptyRows, _mm_cmpeq_epi16(coveredCells, zero));
+            bumpiness = _mm_add_epi8(bumpiness, CountBytes128(_mm_and_si128(_mm_xor_si128(covered, _mm_srli_epi16(covered, 1)), bumpinessMask)));
+
+            __m128i walled = _mm_and_si128(_mm_slli_epi16(covered, 1), _mm_srli_epi16(covered, 1));
+            wellDepth = _mm_add_epi8(wellDepth, CountBytes128(_mm_andnot_si128(covered, _mm_and_si128(walled, playfieldMask))));
+
+            previous = row;
+        }
+
+        columnTransitions = _mm_add_epi8(columnTransitions, CountBytes128(_mm_andnot_si128(previous, playfieldMask)));
+
+        StoreSums128(aggregateHeight, &sums.AggregateHeight[offset]);
+        _mm_storeu_si128((__m128i*)&sums.EmptyRows[offset], emptyRows);
+        StoreSums128(holes, &sums.Holes[offset]);
+        StoreSums128(bumpiness, &sums.Bumpiness[offset]);
+        StoreSums128(wellDepth, &sums.WellDepth[offset]);
+        StoreSums128(rowTransitions, &sums.RowTransitions[offset]);
+        StoreSums128(columnTransitions, &sums.ColumnTransitions[offset]);
+    }
+
+    StoreFeatures(sums, boardCount, outFeatures);
+}
+
+EVALUATOR_TARGET("avx2")
+static __m256i CountBytes256(__m256i value)
+{
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0F);
+
+    __m256i low = _mm256_and_si256(value, lowNibbles);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(value, 4), lowNibbles);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+}
+
+EVALUATOR_TARGET("avx2")
+static void StoreSums256(__m256i byteSums, uint16_t* outSums)
+{
+    __m256i sums = _mm256_add_epi16(_mm256_and_si256(byteSums, _mm256_set1_epi16(0x00FF)), _mm256_srli_epi16(byteSums, 8));
+    _mm256_storeu_si256((__m256i*)outSums, sums);
+}
+
+EVALUATOR_TARGET("avx2")
+static void ComputeFeaturesAVX2(const BoardBatch& batch, uint32_t boardCount, BoardFeatures* outFeatures)
+{
+    const __m256i playfieldMask = _mm256_set1_epi16((int16_t)PlayfieldMask);
+    const __m256i bumpinessMask = _mm256_set1_epi16((int16_t)BumpinessMask);
+    const __m256i rowTransitionMask = _mm256_set1_epi16((int16_t)RowTransitionMask);
+    const __m256i zero = _mm256_setzero_si256();
+
+    __m256i covered = _mm256_set1_epi16((int16_t)Board::EmptyRow);
+    __m256i previous = covered;
+
+    __m256i aggregateHeight = zero, emptyRows = zero, holes = zero, bumpiness = zero;
+    __m256i wellDepth = zero, rowTransitions = zero, columnTransitions = zero;
+
+    for (int i = 0; i < Board::Height; i++)
+    {
+        __m256i row = _mm256_load_si256((const __m256i*)batch.Rows[i]);
+
+        holes = _mm256_add_epi8(holes, CountBytes256(_mm256_andnot_si256(row, _mm256_and_si256(covered, playfieldMask))));
+        columnTransitions = _mm256_add_epi8(columnTransitions, CountBytes256(_mm256_and_si256(_mm256_xor_si256(row, previous), playfieldMask)));
+        rowTransitions = _mm256_add_epi8(rowTransitions, CountBytes256(_mm256_and_si256(_mm256_xor_si256(row, _mm256_srli_epi16(row, 1)), rowTransitionMask)));
+
+        covered = _mm256_or_si256(covered, row);
+        __m256i coveredCells = _mm256_and_si256(covered, playfieldMask);
+
+        aggregateHeight = _mm256_add_epi8(aggregateHeight, CountBytes256(coveredCells));
+        emptyRows = _mm256_sub_epi16(emptyRows, _mm256_cmpeq_epi16(coveredCells, zero));
+        bumpiness = _mm256_add_epi8(bumpiness, CountBytes256(_mm256_and_si256(_mm256_xor_si256(covered, _mm256_srli_epi16(covered, 1)), bumpinessMask)));
+
+        __m256i walled = _mm256_and_si256(_mm256_slli_epi16(covered, 1), _mm256_srli_epi16(covered, 1));
+        wellDepth = _mm256_add_epi8(wellDepth, CountBytes256(_mm256_andnot_si256(covered, _mm256_and_si256(walled, playfieldMask))));
+
+        previous = row;
+    }
+
+    columnTransitions = _mm256_add_epi8(columnTransitions, CountBytes256(_mm256_andnot_si256(previous, playfieldMask)));
+
+    BatchSums sums;
+    StoreSums256(aggregateHeight, sums.AggregateHeight);
+    _mm256_storeu_si256((__m256i*)sums.EmptyRows, emptyRows);
+    StoreSums256(holes, sums.Holes);
+    StoreSums256(bumpiness, sums.Bumpiness);
+    StoreSums256(wellDepth, sums.WellDepth);
+    StoreSums256(rowTransitions, sums.RowTransitions);
+    StoreSums256(columnTransitions, sums.ColumnTransitions);
+
+    StoreFeatures(sums, boardCount, outFeatures);
+}
+
+static FeatureKernel DetectFeatureKernel()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+
+    __cpuid(info, 1);
+    bool sse42 = (info[2] & (1 << 20)) != 0;
+    // AVX state has to be enabled by the OS (OSXSAVE and XCR0) on top of the CPU flag
+    bool avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+    __cpuidex(info, 7, 0);
+    bool avx2 = avx && (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    bool sse42 = __builtin_cpu_supports("sse4.2");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    if (avx2)
+        return FeatureKernel::AVX2;
+
+    if (sse42)
+        return FeatureKernel::SSE42;
+
+    return FeatureKernel::Scalar;
+}
+
+#else
+
+static FeatureKernel DetectFeatureKernel()
+{
+    return FeatureKernel::Scalar;
+}
+
+#endif
+
+FeatureKernel GetFeatureKernel()
+{
+    static const FeatureKernel kernel = DetectFeatureKernel();
+    return kernel;
+}
+
+bool IsFeatureKernelSupported(FeatureKernel kernel)
+{
+    return (int)kernel <= (int)GetFeatureKernel();
+}
+
+const char* GetFeatureKernelName(FeatureKernel kernel)
+{
+    switch (kernel)
+    {
+    case FeatureKernel::Scalar:     return "scalar";
+    case FeatureKernel::SSE42:      return "sse4.2";
+    case FeatureKernel::AVX2:       return "avx2";
+    default:                        return "unknown";
+    }
+}
+
+void ComputeFeatures(const BoardBatch& batch, uint32_t boardCount, BoardFeatures* outFeatures)
+{
+    ComputeFeatures(batch, boardCount, outFeatures, GetFeatureKernel());
+}
+
+void ComputeFeatures(const BoardBatch& batch, uint32_t boardCount, BoardFeatures* outFeatures, FeatureKernel kernel)
+{
+    if (!IsFeatureKernelSupported(kernel))
+        kernel = GetFeatureKernel();
+
+    switch (kernel)
+    {
+#if EVALUATOR_X86
+    case FeatureKernel::AVX2:       ComputeFeaturesAVX2(batch, boardCount, outFeatures); break;
+    case FeatureKernel::SSE42:      ComputeFeaturesSSE42(batch, boardCount, outFeatures); break;
+#endif
+    default:                        ComputeFeaturesScalar(batch, boardCount, outFeatures); break;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Board.h"
+
+// Shape features of a board used by the bot heuristic, heights are counted in cells from the floor
+struct BoardFeatures
+{
+    int32_t AggregateHeight;
+    int32_t MaxHeight;
+    int32_t Holes;
+    int32_t Bumpiness;
+    int32_t WellDepth;
+    int32_t RowTransitions;         // filled/empty changes along every row, walls count as filled
+    int32_t ColumnTransitions;      // filled/empty changes down every column, the floor counts as filled
+};
+
+// Candidate boards stored transposed, Rows[row][i] is row `row` of board i, so that one SIMD lane holds one board
+// and a whole batch is evaluated by a single pass over the rows
+struct BoardBatch
+{
+    static constexpr uint32_t Size = 16;
+
+    alignas(32) uint16_t Rows[Board::Height][Size];
+};
+
+enum class FeatureKernel
+{
+    Scalar,
+    SSE42,
+    AVX2
+};
+
+// Best kernel the CPU supports, detected once
+FeatureKernel GetFeatureKernel();
+bool IsFeatureKernelSupported(FeatureKernel kernel);
+const char* GetFeatureKernelName(FeatureKernel kernel);
+
+// rows are the Board::Height visible rows of a board in the Board row encoding (walls included)
+void ComputeFeatures(const uint16_t* rows, BoardFeatures& outFeatures);
+
+// Features of the first boardCount boards of the batch, lanes past boardCount are evaluated but not written
+void ComputeFeatures(const BoardBatch& batch, uint32_t boardCount, BoardFeatures* outFeatures);
+void ComputeFeatures(const BoardBatch& batch, uint32_t boardCount, BoardFeatures* outFeatures, FeatureKernel kernel);
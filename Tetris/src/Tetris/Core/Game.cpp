@@ -0,0 +1,111 @@
+#include "Game.h"
+
+#include <bitset>
+
+static const uint32_t s_LineScores[] = { 0, 100, 300, 500, 800 };
+
+Game::Game(uint64_t seed)
+    : m_Bag(seed), m_ActivePiece(TetrominoType::I)
+{
+    Reset(seed);
+}
+
+void Game::Reset(uint64_t seed)
+{
+    m_Board.Reset();
+    m_Bag = PieceBag(seed);
+    m_ActivePiece = Piece(m_Bag.Next());
+
+    m_Seed = seed;
+    m_Tick = 0;
+    m_GravityCounter = 0;
+    m_Lines = 0;
+    m_Score = 0;
+    m_PieceCount = 0;
+    m_LastClearedRows = 0;
+    m_GameOver = false;
+}
+
+void Game::Tick(uint8_t input)
+{
+    if (m_GameOver)
+        return;
+
+    m_Tick++;
+    m_LastClearedRows = 0;
+
+    if (input & InputRotate)
+        m_ActivePiece.Rotate(m_Board);
+    if (input & InputRotateCounterClockwise)
+        m_ActivePiece.RotateCounterClockwise(m_Board);
+    if (input & InputLeft)
+        m_ActivePiece.MoveLeft(m_Board);
+    if (input & InputRight)
+        m_ActivePiece.MoveRight(m_Board);
+
+    uint32_t gravityTicks = (input & InputSoftDrop) ? SoftDropGravityTicks : GravityTicks;
+
+    if (++m_GravityCounter < gravityTicks)
+        return;
+
+    m_GravityCounter = 0;
+
+    if (!m_ActivePiece.Move(m_Board))
+        LockActivePiece();
+}
+
+uint32_t Game::GetTicksUntilGravity(uint8_t input) const
+{
+    uint32_t gravityTicks = (input & InputSoftDrop) ? SoftDropGravityTicks : GravityTicks;
+    return m_GravityCounter + 1 < gravityTicks ? gravityTicks - m_GravityCounter : 1;
+}
+
+uint64_t Game::GetStateHash() const
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    auto combine = [&hash](uint64_t value, uint32_t byteCount)
+    {
+        for (uint32_t i = 0; i < byteCount; i++)
+        {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 0x100000001B3ull;
+        }
+    };
+
+    for (int row = -Board::BufferRows; row < Board::Height; row++)
+        combine(m_Board.GetRow(row), 2);
+
+    for (uint32_t i = 0; i < Board::Width * Board::Height; i++)
+        combine(m_Board.GetCell(i), 1);
+
+    combine((uint8_t)m_ActivePiece.GetType(), 1);
+    combine((uint8_t)m_ActivePiece.GetX(), 1);
+    combine((uint8_t)m_ActivePiece.GetY(), 1);
+    combine(m_ActivePiece.GetRotation(), 1);
+
+    combine(m_Tick, 4);
+    combine(m_Lines, 4);
+    combine(m_Score, 4);
+    combine(m_PieceCount, 4);
+    combine(m_GameOver, 1);
+
+    return hash;
+}
+
+void Game::LockActivePiece()
+{
+    m_ActivePiece.Lock(m_Board);
+    m_PieceCount++;
+
+    m_LastClearedRows = m_Board.ClearLines();
+
+    uint32_t clearedCount = std::bitset<32>(m_LastClearedRows).count();
+    m_Lines += clearedCount;
+    m_Score += s_LineScores[clearedCount];
+
+    m_ActivePiece = Piece(m_Bag.Next());
+
+    if (!m_ActivePiece.Fits(m_Board))
+        m_GameOver = true;
+}
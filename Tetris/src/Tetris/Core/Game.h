@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Board.h"
+#include "Piece.h"
+#include "PieceBag.h"
+
+// Fixed tick simulation of one game, the whole state only depends on the seed and the inputs of every tick
+class Game
+{
+public:
+    static constexpr uint32_t TicksPerSecond = 120;
+    static constexpr uint32_t GravityTicks = 60;            // 500 ms
+    static constexpr uint32_t SoftDropGravityTicks = 9;     // 75 ms
+
+    // Inputs of one tick, Left, Right and the rotations are presses, SoftDrop is held
+    enum Input : uint8_t
+    {
+        InputLeft = 1 << 0,
+        InputRight = 1 << 1,
+        InputRotate = 1 << 2,
+        InputRotateCounterClockwise = 1 << 3,
+        InputSoftDrop = 1 << 4
+    };
+
+public:
+    Game(uint64_t seed);
+
+public:
+    void Reset(uint64_t seed);
+    void Tick(uint8_t input);
+
+    // Ticks until gravity next moves the active piece if input stays the same, nothing else changes in between
+    uint32_t GetTicksUntilGravity(uint8_t input) const;
+
+    // FNV-1a over everything that defines the game, used to check that a replay reproduced a session
+    uint64_t GetStateHash() const;
+
+    const Board& GetBoard() const { return m_Board; }
+    const Piece& GetActivePiece() const { return m_ActivePiece; }
+
+    uint64_t GetSeed() const { return m_Seed; }
+    uint32_t GetTick() const { return m_Tick; }
+    uint32_t GetLines() const { return m_Lines; }
+    uint32_t GetScore() const { return m_Score; }
+    uint32_t GetPieceCount() const { return m_PieceCount; }
+    uint32_t GetLastClearedRows() const { return m_LastClearedRows; }
+    bool IsGameOver() const { return m_GameOver; }
+
+private:
+    Board m_Board;
+    PieceBag m_Bag;
+    Piece m_ActivePiece;
+
+    uint64_t m_Seed;
+    uint32_t m_Tick;
+    uint32_t m_GravityCounter;
+    uint32_t m_Lines;
+    uint32_t m_Score;
+    uint32_t m_PieceCount;
+    uint32_t m_LastClearedRows;
+    bool m_GameOver;
+
+private:
+    void LockActivePiece();
+};
@@ -0,0 +1,114 @@
+#include "Piece.h"
+
+static constexpr int s_SpawnX = 3;
+
+Piece::Piece(TetrominoType type)
+    : m_Type(type), m_X(s_SpawnX), m_Y(Tetromino::GetSpawnY(type)), m_Rotation(0), m_Landed(false)
+{
+}
+
+Piece::Piece(TetrominoType type, int x, int y, uint32_t rotation)
+    : m_Type(type), m_X(x), m_Y(y), m_Rotation(rotation & 3), m_Landed(false)
+{
+}
+
+void Piece::Respawn()
+{
+    m_X = s_SpawnX;
+    m_Y = Tetromino::GetSpawnY(m_Type);
+    m_Rotation = 0;
+    m_Landed = false;
+}
+
+bool Piece::Move(const Board& board)
+{
+    if (board.Collides(GetMask(), m_X, m_Y + 1))
+    {
+        m_Landed = true;
+        return false;
+    }
+
+    m_Y++;
+    return true;
+}
+
+bool Piece::MoveLeft(const Board& board)
+{
+    if (board.Collides(GetMask(), m_X - 1, m_Y))
+        return false;
+
+    m_X--;
+    return true;
+}
+
+bool Piece::MoveRight(const Board& board)
+{
+    if (board.Collides(GetMask(), m_X + 1, m_Y))
+        return false;
+
+    m_X++;
+    return true;
+}
+
+bool Piece::Rotate(const Board& board)
+{
+    const PieceMask& mask = Tetromino::GetMask(m_Type, m_Rotation + 1);
+    const KickOffset* kicks = Tetromino::GetKicks(m_Type, m_Rotation);
+
+    for (uint32_t i = 0; i < Tetromino::KickCount; i++)
+    {
+        int x = m_X + kicks[i].X;
+        int y = m_Y + kicks[i].Y;
+
+        if (!Board::IsInBounds(x, y) || board.Collides(mask, x, y))
+            continue;
+
+        m_X = x;
+        m_Y = y;
+        m_Rotation = (m_Rotation + 1) & 3;
+        return true;
+    }
+
+    return false;
+}
+
+bool Piece::RotateCounterClockwise(const Board& board)
+{
+    const PieceMask& mask = Tetromino::GetMask(m_Type, m_Rotation + 3);
+    const KickOffset* kicks = Tetromino::GetKicks(m_Type, m_Rotation + 3);
+
+    for (uint32_t i = 0; i < Tetromino::KickCount; i++)
+    {
+        int x = m_X - kicks[i].X;
+        int y = m_Y - kicks[i].Y;
+
+        if (!Board::IsInBounds(x, y) || board.Collides(mask, x, y))
+            continue;
+
+        m_X = x;
+        m_Y = y;
+        m_Rotation = (m_Rotation + 3) & 3;
+        return true;
+    }
+
+    return false;
+}
+
+void Piece::Overlay(uint8_t* cells) const
+{
+    const PieceMask& mask = GetMask();
+
+    for (int i = 0; i < 4; i++)
+    {
+        int row = m_Y + i;
+
+        if (mask.Rows[i] == 0 || row < 0 || row >= Board::Height)
+            continue;
+
+        for (int j = 0; j < 4; j++)
+        {
+            if (mask.Rows[i] & (1 << j))
+                cells[row * Board::Width + m_X + j] = GetColorID();
+        }
+    }
+}
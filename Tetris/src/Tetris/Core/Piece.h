@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Board.h"
+#include "Tetromino.h"
+
+class Piece
+{
+public:
+    Piece(TetrominoType type);
+    Piece(TetrominoType type, int x, int y, uint32_t rotation);
+
+public:
+    void Respawn();
+
+    // Every movement returns false and leaves the piece untouched when the target position is blocked
+    bool Move(const Board& board);
+    bool MoveLeft(const Board& board);
+    bool MoveRight(const Board& board);
+
+    // Rotations try the wall kicks of the Super Rotation System in order and take the first free position
+    bool Rotate(const Board& board);
+    bool RotateCounterClockwise(const Board& board);
+
+    bool Fits(const Board& board) const { return !board.Collides(GetMask(), m_X, m_Y); }
+    void Lock(Board& board) const { board.Place(GetMask(), m_X, m_Y, GetColorID()); }
+
+    // Writes the color of the piece into a Board::Width * Board::Height color table
+    void Overlay(uint8_t* cells) const;
+
+    bool IsLanded() const { return m_Landed; }
+    int GetX() const { return m_X; }
+    int GetY() const { return m_Y; }
+    uint32_t GetRotation() const { return m_Rotation; }
+    TetrominoType GetType() const { return m_Type; }
+    const PieceMask& GetMask() const { return Tetromino::GetMask(m_Type, m_Rotation); }
+    uint8_t GetColorID() const { return Tetromino::GetColorID(m_Type); }
+
+private:
+    TetrominoType m_Type;
+    int8_t m_X;
+    int8_t m_Y;
+    uint8_t m_Rotation;
+    bool m_Landed;
+};
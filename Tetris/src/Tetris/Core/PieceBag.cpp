@@ -0,0 +1,40 @@
+#include "PieceBag.h"
+
+PieceBag::PieceBag(uint64_t seed)
+    : m_Random(seed), m_Index(Tetromino::Count)
+{
+}
+
+TetrominoType PieceBag::Next()
+{
+    if (m_Index == Tetromino::Count)
+        Refill();
+
+    return m_Pieces[m_Index++];
+}
+
+TetrominoType PieceBag::Peek()
+{
+    if (m_Index == Tetromino::Count)
+        Refill();
+
+    return m_Pieces[m_Index];
+}
+
+void PieceBag::Refill()
+{
+    for (uint32_t i = 0; i < Tetromino::Count; i++)
+        m_Pieces[i] = (TetrominoType)i;
+
+    // Fisher-Yates shuffle
+    for (uint32_t i = Tetromino::Count - 1; i > 0; i--)
+    {
+        uint32_t j = m_Random.NextBelow(i + 1);
+
+        TetrominoType temp = m_Pieces[i];
+        m_Pieces[i] = m_Pieces[j];
+        m_Pieces[j] = temp;
+    }
+
+    m_Index = 0;
+}
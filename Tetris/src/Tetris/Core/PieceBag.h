@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Random.h"
+#include "Tetromino.h"
+
+// 7-bag randomizer, every run of 7 pieces contains each tetromino exactly once
+class PieceBag
+{
+public:
+    PieceBag(uint64_t seed);
+
+public:
+    TetrominoType Next();
+    TetrominoType Peek();
+
+private:
+    Random m_Random;
+    TetrominoType m_Pieces[Tetromino::Count];
+    uint32_t m_Index;
+
+private:
+    void Refill();
+};
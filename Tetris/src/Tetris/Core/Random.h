@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+// SplitMix64, small enough to be copied along with a game snapshot and identical on every platform (and at compile time)
+class Random
+{
+public:
+    constexpr Random(uint64_t seed = 0)
+        : m_State(seed)
+    {}
+
+public:
+    constexpr uint64_t Next()
+    {
+        uint64_t z = (m_State += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform value in [0, bound)
+    constexpr uint32_t NextBelow(uint32_t bound)
+    {
+        return (uint32_t)(((Next() >> 32) * bound) >> 32);
+    }
+
+private:
+    uint64_t m_State;
+};
@@ -0,0 +1,187 @@
+#include "Replay.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+static const char s_Magic[4] = { 'T', 'R', 'P', 'L' };
+static constexpr uint16_t s_Version = 1;
+
+static void WriteInteger(std::vector<uint8_t>& buffer, uint64_t value, uint32_t byteCount)
+{
+    for (uint32_t i = 0; i < byteCount; i++)
+        buffer.push_back((value >> (i * 8)) & 0xFF);
+}
+
+static void WriteVarint(std::vector<uint8_t>& buffer, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+
+    buffer.push_back(value);
+}
+
+static bool ReadInteger(const std::vector<uint8_t>& buffer, size_t& offset, uint64_t& outValue, uint32_t byteCount)
+{
+    if (offset + byteCount > buffer.size())
+        return false;
+
+    outValue = 0;
+    for (uint32_t i = 0; i < byteCount; i++)
+        outValue |= (uint64_t)buffer[offset++] << (i * 8);
+
+    return true;
+}
+
+static bool ReadVarint(const std::vector<uint8_t>& buffer, size_t& offset, uint32_t& outValue)
+{
+    outValue = 0;
+
+    for (uint32_t shift = 0; shift < 35; shift += 7)
+    {
+        if (offset >= buffer.size())
+            return false;
+
+        uint8_t byte = buffer[offset++];
+        outValue |= (uint32_t)(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+Replay::Replay(uint64_t seed)
+    : m_Seed(seed), m_TickCount(0), m_FinalHash(0)
+{
+}
+
+void Replay::Record(uint32_t tick, uint8_t input)
+{
+    if (input != 0)
+        m_Events.push_back({ tick, input });
+}
+
+void Replay::Finish(const Game& game)
+{
+    m_TickCount = game.GetTick();
+    m_FinalHash = game.GetStateHash();
+}
+
+bool Replay::Save(const std::string& filePath) const
+{
+    std::vector<uint8_t> buffer;
+    buffer.reserve(32 + m_Events.size() * 2);
+
+    buffer.insert(buffer.end(), s_Magic, s_Magic + 4);
+    WriteInteger(buffer, s_Version, 2);
+    WriteInteger(buffer, m_Seed, 8);
+    WriteInteger(buffer, m_TickCount, 4);
+    WriteInteger(buffer, m_FinalHash, 8);
+    WriteInteger(buffer, m_Events.size(), 4);
+
+    uint32_t previousTick = 0;
+
+    for (const Event& event : m_Events)
+    {
+        WriteVarint(buffer, event.Tick - previousTick);
+        buffer.push_back(event.Input);
+        previousTick = event.Tick;
+    }
+
+    std::ofstream fileStream(filePath, std::ios::binary);
+
+    if (!fileStream)
+    {
+        std::cout << "Failed to write replay " << filePath << std::endl;
+        return false;
+    }
+
+    fileStream.write((const char*)buffer.data(), buffer.size());
+    return true;
+}
+
+bool Replay::Load(const std::string& filePath)
+{
+    std::ifstream fileStream(filePath, std::ios::binary);
+
+    if (!fileStream)
+    {
+        std::cout << "Failed to open replay " << filePath << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(fileStream)), std::istreambuf_iterator<char>());
+
+    size_t offset = 4;
+    uint64_t version, seed, tickCount, finalHash, eventCount;
+
+    if (buffer.size() < 4 || !std::equal(s_Magic, s_Magic + 4, buffer.begin()) ||
+        !ReadInteger(buffer, offset, version, 2) || version != s_Version ||
+        !ReadInteger(buffer, offset, seed, 8) ||
+        !ReadInteger(buffer, offset, tickCount, 4) ||
+        !ReadInteger(buffer, offset, finalHash, 8) ||
+        !ReadInteger(buffer, offset, eventCount, 4))
+    {
+        std::cout << "Invalid replay header in " << filePath << std::endl;
+        return false;
+    }
+
+    // Every event is at least a one byte delta and the input byte, a count the file can not hold is rejected before
+    // anything is allocated for it
+    if (eventCount > (buffer.size() - offset) / 2)
+    {
+        std::cout << "Truncated replay " << filePath << std::endl;
+        return false;
+    }
+
+    std::vector<Event> events;
+    events.reserve(eventCount);
+
+    uint32_t tick = 0;
+
+    for (uint64_t i = 0; i < eventCount; i++)
+    {
+        uint32_t delta;
+
+        if (!ReadVarint(buffer, offset, delta) || offset >= buffer.size())
+        {
+            std::cout << "Truncated replay " << filePath << std::endl;
+            return false;
+        }
+
+        tick += delta;
+        events.push_back({ tick, buffer[offset++] });
+    }
+
+    m_Seed = seed;
+    m_TickCount = tickCount;
+    m_FinalHash = finalHash;
+    m_Events = std::move(events);
+
+    return true;
+}
+
+bool Replay::Play(Game& game) const
+{
+    game.Reset(m_Seed);
+
+    size_t eventIndex = 0;
+
+    while (game.GetTick() < m_TickCount && !game.IsGameOver())
+    {
+        uint8_t input = 0;
+
+        if (eventIndex < m_Events.size() && m_Events[eventIndex].Tick == game.GetTick())
+            input = m_Events[eventIndex++].Input;
+
+        game.Tick(input);
+    }
+
+    return game.GetStateHash() == m_FinalHash;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Game.h"
+
+// Inputs of one game session, enough to re-run it tick by tick
+//
+// File layout (little endian):
+//   char[4] magic "TRPL", uint16 version, uint64 seed, uint32 tick count, uint64 final state hash, uint32 event count
+//   events: varint tick delta to the previous event, uint8 input
+class Replay
+{
+public:
+    struct Event
+    {
+        uint32_t Tick;
+        uint8_t Input;
+    };
+
+public:
+    Replay(uint64_t seed = 0);
+
+public:
+    // Called with Game::GetTick() and the input right before every Game::Tick(), ticks without input are not stored
+    void Record(uint32_t tick, uint8_t input);
+    // Stores the tick count and the state hash the replay must reproduce
+    void Finish(const Game& game);
+
+    bool Save(const std::string& filePath) const;
+    bool Load(const std::string& filePath);
+
+    // Re-runs the replay on the game as fast as possible, returns true when the final state hash matches
+    bool Play(Game& game) const;
+
+    uint64_t GetSeed() const { return m_Seed; }
+    uint32_t GetTickCount() const { return m_TickCount; }
+    uint64_t GetFinalHash() const { return m_FinalHash; }
+    const std::vector<Event>& GetEvents() const { return m_Events; }
+
+private:
+    uint64_t m_Seed;
+    uint32_t m_TickCount;
+    uint64_t m_FinalHash;
+    std::vector<Event> m_Events;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Board.h"
+
+enum class TetrominoType : uint8_t
+{
+    I, J, L, O, S, T, Z
+};
+
+// Offset tried when a rotation is blocked, y grows downwards like the rows of the board
+struct KickOffset
+{
+    int8_t X;
+    int8_t Y;
+};
+
+// Compile time shape, rotation and wall kick tables of the Super Rotation System
+class Tetromino
+{
+public:
+    static constexpr uint32_t Count = 7;
+    static constexpr uint32_t KickCount = 5;
+
+public:
+    static constexpr const PieceMask& GetMask(TetrominoType type, uint32_t rotation) { return s_Masks[(uint32_t)type][rotation & 3]; }
+    static constexpr const PieceMask& GetMask(uint32_t type, uint32_t rotation) { return s_Masks[type][rotation & 3]; }
+    static constexpr uint8_t GetColorID(TetrominoType type) { return s_ColorIDs[(uint32_t)type]; }
+
+    // Row of the bounding box the piece spawns at, chosen so that the piece appears in the top row of the board
+    static constexpr int GetSpawnY(TetrominoType type) { return (s_Masks[(uint32_t)type][0].Rows[0] == 0) ? -1 : 0; }
+
+    // Kicks for the clockwise rotation out of the given state, a counter clockwise rotation out of
+    // state N + 1 uses the same offsets negated
+    static constexpr const KickOffset* GetKicks(TetrominoType type, uint32_t rotation)
+    {
+        if (type == TetrominoType::O)
+            return s_NoKicks;
+
+        return (type == TetrominoType::I) ? s_IKicks[rotation & 3] : s_Kicks[rotation & 3];
+    }
+
+    // Rotates a mask by 90 degrees clockwise inside a boxSize x boxSize bounding box
+    static constexpr PieceMask RotateClockwise(const PieceMask& mask, int boxSize)
+    {
+        PieceMask rotated = {};
+
+        for (int row = 0; row < boxSize; row++)
+        {
+            for (int column = 0; column < boxSize; column++)
+            {
+                if (mask.Rows[row] & (1 << column))
+                    rotated.Rows[column] |= 1 << (boxSize - 1 - row);
+            }
+        }
+
+        return rotated;
+    }
+
+private:
+    // Rotation states 0, R, 2 and L of every piece, the I piece uses a 4x4 box and the others a 3x3 box
+    static constexpr PieceMask s_Masks[Count][4] = {
+        { { { 0x0, 0xF, 0x0, 0x0 } }, { { 0x4, 0x4, 0x4, 0x4 } }, { { 0x0, 0x0, 0xF, 0x0 } }, { { 0x2, 0x2, 0x2, 0x2 } } },     // I
+        { { { 0x1, 0x7, 0x0, 0x0 } }, { { 0x6, 0x2, 0x2, 0x0 } }, { { 0x0, 0x7, 0x4, 0x0 } }, { { 0x2, 0x2, 0x3, 0x0 } } },     // J
+        { { { 0x4, 0x7, 0x0, 0x0 } }, { { 0x2, 0x2, 0x6, 0x0 } }, { { 0x0, 0x7, 0x1, 0x0 } }, { { 0x3, 0x2, 0x2, 0x0 } } },     // L
+        { { { 0x6, 0x6, 0x0, 0x0 } }, { { 0x6, 0x6, 0x0, 0x0 } }, { { 0x6, 0x6, 0x0, 0x0 } }, { { 0x6, 0x6, 0x0, 0x0 } } },     // O
+        { { { 0x6, 0x3, 0x0, 0x0 } }, { { 0x2, 0x6, 0x4, 0x0 } }, { { 0x0, 0x6, 0x3, 0x0 } }, { { 0x1, 0x3, 0x2, 0x0 } } },     // S
+        { { { 0x2, 0x7, 0x0, 0x0 } }, { { 0x2, 0x6, 0x2, 0x0 } }, { { 0x0, 0x7, 0x2, 0x0 } }, { { 0x2, 0x3, 0x2, 0x0 } } },     // T
+        { { { 0x3, 0x6, 0x0, 0x0 } }, { { 0x4, 0x6, 0x2, 0x0 } }, { { 0x0, 0x3, 0x6, 0x0 } }, { { 0x2, 0x3, 0x1, 0x0 } } }      // Z
+    };
+
+    static constexpr uint8_t s_ColorIDs[Count] = { 7, 1, 2, 3, 4, 5, 6 };
+
+    static constexpr KickOffset s_NoKicks[KickCount] = { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+
+    static constexpr KickOffset s_Kicks[4][KickCount] = {
+        { { 0, 0 }, { -1, 0 }, { -1, -1 }, { 0, 2 }, { -1, 2 } },      // 0 -> R
+        { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, -2 }, { 1, -2 } },        // R -> 2
+        { { 0, 0 }, { 1, 0 }, { 1, -1 }, { 0, 2 }, { 1, 2 } },         // 2 -> L
+        { { 0, 0 }, { -1, 0 }, { -1, 1 }, { 0, -2 }, { -1, -2 } }      // L -> 0
+    };
+
+    static constexpr KickOffset s_IKicks[4][KickCount] = {
+        { { 0, 0 }, { -2, 0 }, { 1, 0 }, { -2, 1 }, { 1, -2 } },       // 0 -> R
+        { { 0, 0 }, { -1, 0 }, { 2, 0 }, { -1, -2 }, { 2, 1 } },       // R -> 2
+        { { 0, 0 }, { 2, 0 }, { -1, 0 }, { 2, -1 }, { -1, 2 } },       // 2 -> L
+        { { 0, 0 }, { 1, 0 }, { -2, 0 }, { 1, 2 }, { -2, -1 } }        // L -> 0
+    };
+};
+
+constexpr bool ValidateRotationTables()
+{
+    for (uint32_t type = 0; type < Tetromino::Count; type++)
+    {
+        if (type == (uint32_t)TetrominoType::O)
+            continue;
+
+        int boxSize = (type == (uint32_t)TetrominoType::I) ? 4 : 3;
+
+        for (uint32_t rotation = 0; rotation < 4; rotation++)
+        {
+            PieceMask rotated = Tetromino::RotateClockwise(Tetromino::GetMask(type, rotation), boxSize);
+
+            for (int row = 0; row < 4; row++)
+            {
+                if (rotated.Rows[row] != Tetromino::GetMask(type, rotation + 1).Rows[row])
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static_assert(ValidateRotationTables(), "Every rotation state must be the previous one turned clockwise");
@@ -0,0 +1,147 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+    : m_ThreadCount(threadCount), m_Generation(0), m_BusyWorkers(0), m_Running(true), m_Job(nullptr), m_StealCount(0)
+{
+    if (m_ThreadCount == 0)
+        m_ThreadCount = std::thread::hardware_concurrency();
+
+    if (m_ThreadCount == 0)
+        m_ThreadCount = 1;
+
+    m_Ranges.reset(new Range[m_ThreadCount]);
+
+    m_Threads.reserve(m_ThreadCount - 1);
+    for (uint32_t i = 1; i < m_ThreadCount; i++)
+        m_Threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+
+    m_StartCondition.notify_all();
+
+    for (std::thread& thread : m_Threads)
+        thread.join();
+}
+
+void ThreadPool::ParallelFor(uint64_t count, const Job& job)
+{
+    if (count == 0)
+        return;
+
+    // Contiguous and even split, stealing only has to correct the imbalance of the items themselves
+    for (uint32_t i = 0; i < m_ThreadCount; i++)
+    {
+        std::lock_guard<std::mutex> lock(m_Ranges[i].Mutex);
+        m_Ranges[i].Begin = count * i / m_ThreadCount;
+        m_Ranges[i].End = count * (i + 1) / m_ThreadCount;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Job = &job;
+        m_BusyWorkers = m_ThreadCount;
+        m_Generation++;
+    }
+
+    m_StartCondition.notify_all();
+
+    RunJob(0);
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_DoneCondition.wait(lock, [this]() { return m_BusyWorkers == 0; });
+    m_Job = nullptr;
+}
+
+void ThreadPool::WorkerLoop(uint32_t worker)
+{
+    uint64_t generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_StartCondition.wait(lock, [&]() { return !m_Running || m_Generation != generation; });
+
+            if (!m_Running)
+                return;
+
+            generation = m_Generation;
+        }
+
+        RunJob(worker);
+    }
+}
+
+void ThreadPool::RunJob(uint32_t worker)
+{
+    const Job& job = *m_Job;
+    uint64_t index;
+
+    do
+    {
+        while (PopIndex(worker, index))
+            job(index, worker);
+    }
+    while (Steal(worker));
+
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        done = --m_BusyWorkers == 0;
+    }
+
+    if (done)
+        m_DoneCondition.notify_one();
+}
+
+bool ThreadPool::PopIndex(uint32_t worker, uint64_t& outIndex)
+{
+    Range& range = m_Ranges[worker];
+    std::lock_guard<std::mutex> lock(range.Mutex);
+
+    if (range.Begin == range.End)
+        return false;
+
+    outIndex = range.Begin++;
+    return true;
+}
+
+bool ThreadPool::Steal(uint32_t worker)
+{
+    // Victims are visited starting with the next worker, so that thieves spread out instead of all hitting worker 0
+    for (uint32_t i = 1; i < m_ThreadCount; i++)
+    {
+        Range& victim = m_Ranges[(worker + i) % m_ThreadCount];
+        uint64_t begin, end;
+
+        {
+            std::lock_guard<std::mutex> lock(victim.Mutex);
+
+            uint64_t remaining = victim.End - victim.Begin;
+            if (remaining == 0)
+                continue;
+
+            end = victim.End;
+            begin = end - (remaining + 1) / 2;
+            victim.End = begin;
+        }
+
+        Range& range = m_Ranges[worker];
+        {
+            std::lock_guard<std::mutex> lock(range.Mutex);
+            range.Begin = begin;
+            range.End = end;
+        }
+
+        m_StealCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads for data parallel jobs. ParallelFor splits the index range evenly between the workers,
+// each worker takes indices from the front of its own range and, once that is empty, steals the back half of
+// another worker's range, so a few very long items (e.g. long games) do not leave the other cores idle
+class ThreadPool
+{
+public:
+    using Job = std::function<void(uint64_t index, uint32_t worker)>;
+
+public:
+    // 0 uses one worker per hardware thread, the calling thread counts as worker 0
+    ThreadPool(uint32_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+public:
+    // Calls job for every index in [0, count) and returns once all of them are done
+    void ParallelFor(uint64_t count, const Job& job);
+
+    uint32_t GetThreadCount() const { return m_ThreadCount; }
+    uint64_t GetStealCount() const { return m_StealCount.load(std::memory_order_relaxed); }
+
+private:
+    // Each range sits on its own cache line so that workers popping their own range do not slow each other down
+    struct alignas(64) Range
+    {
+        std::mutex Mutex;
+        uint64_t Begin = 0;
+        uint64_t End = 0;
+    };
+
+    uint32_t m_ThreadCount;
+    std::vector<std::thread> m_Threads;
+    std::unique_ptr<Range[]> m_Ranges;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_StartCondition;
+    std::condition_variable m_DoneCondition;
+    uint64_t m_Generation;
+    uint32_t m_BusyWorkers;
+    bool m_Running;
+
+    const Job* m_Job;
+    std::atomic<uint64_t> m_StealCount;
+
+private:
+    void WorkerLoop(uint32_t worker);
+    void RunJob(uint32_t worker);
+
+    bool PopIndex(uint32_t worker, uint64_t& outIndex);
+    bool Steal(uint32_t worker);
+};
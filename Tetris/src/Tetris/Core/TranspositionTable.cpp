@@ -0,0 +1,89 @@
+#include "TranspositionTable.h"
+
+TranspositionTable::TranspositionTable(size_t sizeBytes)
+    : m_EntryCount(1), m_Hits(0), m_Misses(0), m_Stores(0), m_Evictions(0)
+{
+    while (m_EntryCount * 2 * sizeof(Entry) <= sizeBytes)
+        m_EntryCount *= 2;
+
+    m_Entries.reset(new Entry[m_EntryCount]);
+    Clear();
+}
+
+bool TranspositionTable::Probe(uint64_t key, uint64_t* outData)
+{
+    Entry& entry = m_Entries[key & (m_EntryCount - 1)];
+
+    uint64_t check = entry.Check.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < DataWords; i++)
+    {
+        outData[i] = entry.Data[i].load(std::memory_order_relaxed);
+        check ^= outData[i];
+    }
+
+    if (check != key)
+    {
+        m_Misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    m_Hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void TranspositionTable::Store(uint64_t key, const uint64_t* data)
+{
+    Entry& entry = m_Entries[key & (m_EntryCount - 1)];
+
+    // Key of the entry being replaced, all zero means the slot was never written
+    uint64_t previousKey = entry.Check.load(std::memory_order_relaxed);
+    bool empty = previousKey == 0;
+
+    for (uint32_t i = 0; i < DataWords; i++)
+    {
+        uint64_t previousData = entry.Data[i].load(std::memory_order_relaxed);
+        previousKey ^= previousData;
+        empty = empty && previousData == 0;
+    }
+
+    if (!empty && previousKey != key)
+        m_Evictions.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t check = key;
+    for (uint32_t i = 0; i < DataWords; i++)
+    {
+        entry.Data[i].store(data[i], std::memory_order_relaxed);
+        check ^= data[i];
+    }
+
+    entry.Check.store(check, std::memory_order_release);
+    m_Stores.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::Clear()
+{
+    for (size_t i = 0; i < m_EntryCount; i++)
+    {
+        m_Entries[i].Check.store(0, std::memory_order_relaxed);
+        for (uint32_t j = 0; j < DataWords; j++)
+            m_Entries[i].Data[j].store(0, std::memory_order_relaxed);
+    }
+}
+
+TranspositionTable::Stats TranspositionTable::GetStats() const
+{
+    Stats stats;
+    stats.Hits = m_Hits.load(std::memory_order_relaxed);
+    stats.Misses = m_Misses.load(std::memory_order_relaxed);
+    stats.Stores = m_Stores.load(std::memory_order_relaxed);
+    stats.Evictions = m_Evictions.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void TranspositionTable::ResetStats()
+{
+    m_Hits.store(0, std::memory_order_relaxed);
+    m_Misses.store(0, std::memory_order_relaxed);
+    m_Stores.store(0, std::memory_order_relaxed);
+    m_Evictions.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+
+// Fixed size, direct mapped cache of search results keyed by a 64 bit hash, shared by any number of threads without
+// locks. Every entry stores its check word as key ^ data, a reader that races with a writer sees a mismatching check
+// and treats the entry as a miss, so torn entries are never returned
+class TranspositionTable
+{
+public:
+    static constexpr uint32_t DataWords = 3;
+
+    struct Stats
+    {
+        uint64_t Hits;
+        uint64_t Misses;
+        uint64_t Stores;
+        uint64_t Evictions;     // stores that replaced an entry with a different key
+    };
+
+public:
+    // sizeBytes is rounded down to a power of two number of entries
+    TranspositionTable(size_t sizeBytes);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+public:
+    // Key 0 is reserved, it matches the all zero entries of an empty table
+    bool Probe(uint64_t key, uint64_t* outData);
+    void Store(uint64_t key, const uint64_t* data);
+
+    void Clear();
+
+    Stats GetStats() const;
+    void ResetStats();
+
+    size_t GetEntryCount() const { return m_EntryCount; }
+    size_t GetSizeBytes() const { return m_EntryCount * sizeof(Entry); }
+
+private:
+    struct alignas(32) Entry
+    {
+        std::atomic<uint64_t> Check;
+        std::atomic<uint64_t> Data[DataWords];
+    };
+
+    std::unique_ptr<Entry[]> m_Entries;
+    size_t m_EntryCount;
+
+    std::atomic<uint64_t> m_Hits;
+    std::atomic<uint64_t> m_Misses;
+    std::atomic<uint64_t> m_Stores;
+    std::atomic<uint64_t> m_Evictions;
+};
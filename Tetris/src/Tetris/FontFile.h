@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary font written by FontBaker and memory mapped by Font::LoadBaked: a FontFileHeader, GlyphCount FontFileGlyph
+// records at GlyphOffset and the atlas texels at TexelOffset. The texels are stored bottom row first, ready for
+// glTexImage2D, with 4 channels (RGBA) or 1 (coverage of white glyphs). Little endian, like every target we build for
+//
+// Distance field fonts (FontFileFlagDistanceField) store one channel holding 0.5 + distance / (2 * DistanceRange),
+// the signed distance to the glyph outline in font pixels (positive inside). Their atlas is sampled at a lower
+// resolution than the font, the glyph sizes and offsets stay in font pixels and only X, Y refer to atlas texels
+static constexpr uint32_t FontFileMagic = 0x544E4F46;     // "FONT"
+static constexpr uint32_t FontFileVersion = 2;
+static constexpr uint32_t FontFileTexelAlignment = 16;
+
+static constexpr uint32_t FontFileFlagDistanceField = 1 << 0;
+
+struct FontFileHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t GlyphCount;
+    uint32_t TextureWidth;
+    uint32_t TextureHeight;
+    uint32_t ChannelCount;
+    uint32_t Flags;
+    float DistanceRange;        // font pixels, 0 unless FontFileFlagDistanceField
+    uint64_t GlyphOffset;
+    uint64_t TexelOffset;
+    uint64_t TexelSize;
+};
+
+// Same layout as Font::Character so the table is copied in one go
+struct FontFileGlyph
+{
+    uint32_t CharID;
+    int32_t X, Y;
+    int32_t Width, Height;
+    int32_t XOffset, YOffset;
+    int32_t XAdvance;
+    float U0, V0;
+    float U1, V1;
+};
+
+static_assert(sizeof(FontFileHeader) == 56, "FontFileHeader must not contain padding");
+static_assert(sizeof(FontFileGlyph) == 48, "FontFileGlyph must not contain padding");
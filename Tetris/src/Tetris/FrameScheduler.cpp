@@ -0,0 +1,92 @@
+#include "FrameScheduler.h"
+
+#include <iostream>
+
+#include <GLFW/glfw3.h>
+
+FrameScheduler::FrameScheduler(const Settings& settings)
+    : m_Settings(settings), m_Invalidated(true), m_RenderPending(false), m_NextFrameTime(0.0),
+      m_ReportStartTime(glfwGetTime()), m_ReportStartClock(std::clock()), m_LoopCount(0), m_RenderedFrameCount(0), m_SleepTime(0.0)
+{
+    glfwSwapInterval(m_Settings.VSync ? 1 : 0);
+}
+
+bool FrameScheduler::ShouldRender(bool changed)
+{
+    m_LoopCount++;
+
+    if (changed || m_Invalidated || !m_Settings.RenderOnChange)
+        m_RenderPending = true;
+
+    m_Invalidated = false;
+
+    if (!m_RenderPending)
+        return false;
+
+    return m_Settings.MaxFrameRate <= 0.0 || glfwGetTime() >= m_NextFrameTime;
+}
+
+void FrameScheduler::FrameRendered()
+{
+    double time = glfwGetTime();
+
+    m_RenderPending = false;
+    m_RenderedFrameCount++;
+
+    if (m_Settings.MaxFrameRate > 0.0)
+    {
+        // Keep the cadence when on time, restart it after an idle stretch
+        m_NextFrameTime += 1.0 / m_Settings.MaxFrameRate;
+        if (m_NextFrameTime < time)
+            m_NextFrameTime = time;
+    }
+}
+
+void FrameScheduler::Wait(double secondsUntilUpdate)
+{
+    double time = glfwGetTime();
+    double timeout = secondsUntilUpdate;
+
+    bool wantsFrame = m_RenderPending || !m_Settings.RenderOnChange;
+
+    if (wantsFrame && m_Settings.MaxFrameRate > 0.0 && m_NextFrameTime - time < timeout)
+        timeout = m_NextFrameTime - time;
+
+    // Rendering every frame without a cap, only the swap (VSync) limits the loop
+    if (!m_Settings.RenderOnChange && m_Settings.MaxFrameRate <= 0.0)
+        timeout = 0.0;
+
+    if (timeout > 0.0)
+        glfwWaitEventsTimeout(timeout);
+    else
+        glfwPollEvents();
+
+    m_SleepTime += glfwGetTime() - time;
+}
+
+bool FrameScheduler::IsReportDue() const
+{
+    return m_Settings.ReportStats && glfwGetTime() - m_ReportStartTime >= ReportInterval;
+}
+
+void FrameScheduler::Report()
+{
+    double time = glfwGetTime();
+    std::clock_t clock = std::clock();
+
+    double seconds = time - m_ReportStartTime;
+    double cpuMilliseconds = 1000.0 * (clock - m_ReportStartClock) / CLOCKS_PER_SEC;
+
+    std::cout << "frames loops=" << m_LoopCount
+              << " rendered=" << m_RenderedFrameCount
+              << " fps=" << m_RenderedFrameCount / seconds
+              << " cpu_ms_per_frame=" << (m_RenderedFrameCount ? cpuMilliseconds / m_RenderedFrameCount : 0.0)
+              << " cpu_percent=" << cpuMilliseconds / (10.0 * seconds)
+              << " sleep_percent=" << 100.0 * m_SleepTime / seconds << std::endl;
+
+    m_ReportStartTime = time;
+    m_ReportStartClock = clock;
+    m_LoopCount = 0;
+    m_RenderedFrameCount = 0;
+    m_SleepTime = 0.0;
+}
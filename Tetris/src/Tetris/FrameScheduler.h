@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+
+// Decides when the main loop renders and puts it to sleep in between. Instead of spinning, the loop blocks in
+// glfwWaitEventsTimeout until an input event arrives, the simulation has something to do or the next frame of the
+// frame rate cap is due, so an idle board costs close to no CPU time
+class FrameScheduler
+{
+public:
+    struct Settings
+    {
+        bool VSync = true;
+        double MaxFrameRate = 0.0;      // 0 renders without a cap (VSync still applies)
+        bool RenderOnChange = true;     // only render frames in which something on screen changed
+        bool ReportStats = false;       // print frame and CPU time statistics every ReportInterval seconds
+    };
+
+    static constexpr double ReportInterval = 5.0;
+
+public:
+    // Sets the swap interval of the current context
+    FrameScheduler(const Settings& settings);
+
+public:
+    // Forces the next frame to be rendered, called from the window refresh callback
+    void Invalidate() { m_Invalidated = true; }
+
+    // changed tells whether the simulation changed anything visible since the last call
+    bool ShouldRender(bool changed);
+    // Called after the frame was swapped
+    void FrameRendered();
+
+    // Sleeps until an input event arrives, secondsUntilUpdate pass or the next frame is due
+    void Wait(double secondsUntilUpdate);
+
+    // Statistics are printed by the caller so that other per interval statistics can go along with them
+    bool IsReportDue() const;
+    void Report();
+
+    const Settings& GetSettings() const { return m_Settings; }
+
+private:
+    Settings m_Settings;
+
+    bool m_Invalidated;
+    bool m_RenderPending;
+    double m_NextFrameTime;
+
+    // Statistics of the current report interval
+    double m_ReportStartTime;
+    std::clock_t m_ReportStartClock;
+    uint32_t m_LoopCount;
+    uint32_t m_RenderedFrameCount;
+    double m_SleepTime;
+};
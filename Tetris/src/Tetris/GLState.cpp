@@ -0,0 +1,225 @@
+#include "GLState.h"
+
+#include <cstring>
+
+#include <glad/glad.h>
+
+// No GL object has this name, a binding set to it is unknown and the next bind is always issued
+static constexpr uint32_t UnknownBinding = UINT32_MAX;
+
+GLState::GLState()
+    : m_ProgramID(UnknownBinding), m_VertexArrayID(UnknownBinding), m_ActiveTextureUnit(UnknownBinding), m_TextureIDs(), m_TextureArrayIDs(),
+      m_DepthTest(-1), m_ClearColor(0.0f), m_ClearColorValid(false), m_ProjectionBufferID(0), m_ProjectionMatrix(1.0f), m_ProjectionValid(false)
+{
+    Invalidate();
+
+    glGenBuffers(1, &m_ProjectionBufferID);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ProjectionBufferID);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, ProjectionBinding, m_ProjectionBufferID);
+}
+
+GLState::~GLState()
+{
+    glDeleteBuffers(1, &m_ProjectionBufferID);
+}
+
+void GLState::UseProgram(uint32_t programID)
+{
+    if (m_ProgramID == programID)
+    {
+        m_Stats.Elided++;
+        return;
+    }
+
+    glUseProgram(programID);
+    m_ProgramID = programID;
+    m_Stats.Issued++;
+}
+
+void GLState::BindVertexArray(uint32_t vertexArrayID)
+{
+    if (m_VertexArrayID == vertexArrayID)
+    {
+        m_Stats.Elided++;
+        return;
+    }
+
+    glBindVertexArray(vertexArrayID);
+    m_VertexArrayID = vertexArrayID;
+    m_Stats.Issued++;
+}
+
+void GLState::BindTexture(uint32_t unit, uint32_t textureID)
+{
+    if (m_TextureIDs[unit] == textureID)
+    {
+        m_Stats.Elided++;
+        return;
+    }
+
+    SetActiveTextureUnit(unit);
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    m_TextureIDs[unit] = textureID;
+    m_Stats.Issued++;
+}
+
+void GLState::BindTextureArray(uint32_t unit, uint32_t textureID)
+{
+    if (m_TextureArrayIDs[unit] == textureID)
+    {
+        m_Stats.Elided++;
+        return;
+    }
+
+    SetActiveTextureUnit(unit);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    m_TextureArrayIDs[unit] = textureID;
+    m_Stats.Issued++;
+}
+
+void GLState::SetDepthTest(bool enabled)
+{
+    if (m_DepthTest == (int)enabled)
+    {
+        m_Stats.Elided++;
+        return;
+    }
+
+    if (enabled)
+        glEnable(GL_DEPTH_TEST);
+    else
+        glDisable(GL_DEPTH_TEST);
+
+    m_DepthTest = enabled;
+    m_Stats.Issued++;
+}
+
+void GLState::SetClearColor(const glm::vec4& color)
+{
+    if (m_ClearColorValid && m_ClearColor == color)
+    {
+        m_Stats.Elided++;
+        return;
+    }
+
+    glClearColor(color.r, color.g, color.b, color.a);
+    m_ClearColor = color;
+    m_ClearColorValid = true;
+    m_Stats.Issued++;
+}
+
+void GLState::SetUniform(int location, int value)
+{
+    if (UpdateUniform(location, &value, sizeof(value)))
+        glUniform1i(location, value);
+}
+
+void GLState::SetUniform(int location, float value)
+{
+    if (UpdateUniform(location, &value, sizeof(value)))
+        glUniform1f(location, value);
+}
+
+void GLState::SetUniform(int location, const glm::vec2& value)
+{
+    if (UpdateUniform(location, &value, sizeof(value)))
+        glUniform2f(location, value.x, value.y);
+}
+
+void GLState::SetUniform(int location, const glm::vec4& value)
+{
+    if (UpdateUniform(location, &value, sizeof(value)))
+        glUniform4f(location, value.r, value.g, value.b, value.a);
+}
+
+void GLState::SetUniform(int location, const glm::mat4& value)
+{
+    if (UpdateUniform(location, &value, sizeof(value)))
+        glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+}
+
+void GLState::SetProjectionMatrix(const glm::mat4& projectionMatrix)
+{
+    if (m_ProjectionValid && m_ProjectionMatrix == projectionMatrix)
+    {
+        m_Stats.Elided++;
+        return;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ProjectionBufferID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), &projectionMatrix[0][0]);
+
+    m_ProjectionMatrix = projectionMatrix;
+    m_ProjectionValid = true;
+    m_Stats.Issued++;
+}
+
+void GLState::BindProjectionBlock(uint32_t programID)
+{
+    uint32_t blockIndex = glGetUniformBlockIndex(programID, "Projection");
+
+    if (blockIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(programID, blockIndex, ProjectionBinding);
+}
+
+void GLState::Invalidate()
+{
+    m_ProgramID = UnknownBinding;
+    m_VertexArrayID = UnknownBinding;
+    m_ActiveTextureUnit = UnknownBinding;
+    m_ClearColorValid = false;
+    m_DepthTest = -1;
+
+    for (uint32_t i = 0; i < TextureUnitCount; i++)
+    {
+        m_TextureIDs[i] = UnknownBinding;
+        m_TextureArrayIDs[i] = UnknownBinding;
+    }
+
+    m_Uniforms.clear();
+}
+
+void GLState::SetActiveTextureUnit(uint32_t unit)
+{
+    if (m_ActiveTextureUnit == unit)
+        return;
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+    m_ActiveTextureUnit = unit;
+    m_Stats.Issued++;
+}
+
+bool GLState::UpdateUniform(int location, const void* value, uint32_t size)
+{
+    // Uniform values belong to the program, they stay valid across program switches
+    UniformValue* uniform = nullptr;
+
+    for (UniformValue& cached : m_Uniforms)
+    {
+        if (cached.ProgramID == m_ProgramID && cached.Location == location)
+        {
+            uniform = &cached;
+            break;
+        }
+    }
+
+    if (uniform && std::memcmp(uniform->Value, value, size) == 0)
+    {
+        m_Stats.Elided++;
+        return false;
+    }
+
+    if (!uniform)
+    {
+        m_Uniforms.push_back({ m_ProgramID, location, {} });
+        uniform = &m_Uniforms.back();
+    }
+
+    std::memcpy(uniform->Value, value, size);
+    m_Stats.Issued++;
+
+    return true;
+}
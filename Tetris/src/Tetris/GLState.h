@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Mirrors the bindings and uniform values the renderers set every frame, setting what is already current is skipped
+// instead of reaching the driver. Once rendering started, programs, vertex arrays and textures have to be bound and
+// the depth test switched through it (or Invalidate called afterwards). Element buffers belong to the vertex array and
+// buffer updates go through GL_COPY_WRITE_BUFFER, so neither disturbs the tracked state
+class GLState
+{
+public:
+    static constexpr uint32_t TextureUnitCount = 4;
+    // Binding point of the `layout(std140) uniform Projection { mat4 u_ProjectionMatrix; }` block of every shader
+    static constexpr uint32_t ProjectionBinding = 0;
+
+    struct Stats
+    {
+        uint32_t Issued = 0;
+        uint32_t Elided = 0;
+        uint32_t DrawCalls = 0;
+        uint32_t Frames = 0;
+    };
+
+public:
+    GLState();
+    ~GLState();
+
+public:
+    void UseProgram(uint32_t programID);
+    void BindVertexArray(uint32_t vertexArrayID);
+    void BindTexture(uint32_t unit, uint32_t textureID);
+    // GL_TEXTURE_2D_ARRAY binding of the unit, tracked apart from the GL_TEXTURE_2D one
+    void BindTextureArray(uint32_t unit, uint32_t textureID);
+    void SetDepthTest(bool enabled);
+    void SetClearColor(const glm::vec4& color);
+
+    // Uniforms of the current program
+    void SetUniform(int location, int value);
+    void SetUniform(int location, float value);
+    void SetUniform(int location, const glm::vec2& value);
+    void SetUniform(int location, const glm::vec4& value);
+    void SetUniform(int location, const glm::mat4& value);
+
+    // The projection lives in a uniform buffer shared by all programs, it is only written when it changed
+    void SetProjectionMatrix(const glm::mat4& projectionMatrix);
+    // Connects the Projection block of a freshly linked program to the shared buffer
+    static void BindProjectionBlock(uint32_t programID);
+
+    // Forgets the cached bindings and uniform values, needed after objects were deleted (a program name may come back
+    // for a new program) or bound without going through the cache
+    void Invalidate();
+
+    // Calls issued to and elided from the driver and draw calls since the last reset
+    const Stats& GetStats() const { return m_Stats; }
+    void ResetStats() { m_Stats = Stats(); }
+    void CountDrawCall() { m_Stats.DrawCalls++; }
+    void FrameRendered() { m_Stats.Frames++; }
+
+private:
+    struct UniformValue
+    {
+        uint32_t ProgramID;
+        int Location;
+        float Value[16];
+    };
+
+    uint32_t m_ProgramID;
+    uint32_t m_VertexArrayID;
+    uint32_t m_ActiveTextureUnit;
+    uint32_t m_TextureIDs[TextureUnitCount];
+    uint32_t m_TextureArrayIDs[TextureUnitCount];
+    int m_DepthTest;                // -1 while unknown
+    glm::vec4 m_ClearColor;
+    bool m_ClearColorValid;
+
+    uint32_t m_ProjectionBufferID;
+    glm::mat4 m_ProjectionMatrix;
+    bool m_ProjectionValid;
+
+    std::vector<UniformValue> m_Uniforms;
+
+    Stats m_Stats;
+
+private:
+    void SetActiveTextureUnit(uint32_t unit);
+    // Stores the value and returns true when it differs from the cached one
+    bool UpdateUniform(int location, const void* value, uint32_t size);
+};
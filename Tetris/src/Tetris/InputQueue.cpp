@@ -0,0 +1,94 @@
+#include "InputQueue.h"
+
+#include "Core/Game.h"
+
+static const uint8_t s_ActionInputs[InputQueue::ActionCount] = { Game::InputLeft, Game::InputRight, Game::InputRotate, Game::InputSoftDrop };
+
+InputQueue::InputQueue(const Settings& settings)
+    : m_Settings(settings), m_EventBegin(0), m_Held(), m_ShiftAction(-1), m_NextRepeatTime(0.0), m_LatencyStats()
+{
+    m_Events.reserve(64);
+}
+
+void InputQueue::Push(Action action, bool pressed, double time)
+{
+    m_Events.push_back({ time, action, pressed });
+}
+
+uint8_t InputQueue::ConsumeTick(double tickEndTime, double now)
+{
+    uint8_t input = 0;
+
+    while (m_EventBegin < m_Events.size() && m_Events[m_EventBegin].Time < tickEndTime)
+    {
+        const Event& event = m_Events[m_EventBegin++];
+
+        if (event.Pressed)
+        {
+            // Key repeat events of the OS are not forwarded, a second press of a held key is ignored
+            if (m_Held[event.Type])
+                continue;
+
+            m_Held[event.Type] = true;
+            input |= s_ActionInputs[event.Type];
+
+            if (event.Type == ActionLeft || event.Type == ActionRight)
+                StartShift(event.Type, event.Time);
+
+            double latency = now - event.Time;
+            m_LatencyStats.Presses++;
+            m_LatencyStats.TotalLatency += latency;
+            if (latency > m_LatencyStats.MaxLatency)
+                m_LatencyStats.MaxLatency = latency;
+        }
+        else
+        {
+            m_Held[event.Type] = false;
+
+            // Releasing the shifting direction hands over to the other one if it is still held
+            if (event.Type == m_ShiftAction)
+            {
+                Action other = event.Type == ActionLeft ? ActionRight : ActionLeft;
+
+                if (m_Held[other])
+                    StartShift(other, event.Time);
+                else
+                    m_ShiftAction = -1;
+            }
+        }
+    }
+
+    if (m_EventBegin == m_Events.size())
+    {
+        m_Events.clear();
+        m_EventBegin = 0;
+    }
+
+    if (m_ShiftAction >= 0 && m_NextRepeatTime < tickEndTime)
+    {
+        input |= s_ActionInputs[m_ShiftAction];
+
+        // The game moves at most one cell per tick, repeats that fell into a long sleep are dropped
+        m_NextRepeatTime += m_Settings.AutoRepeatRate;
+        if (m_NextRepeatTime < tickEndTime)
+            m_NextRepeatTime = tickEndTime;
+    }
+
+    return input | GetHeldInput();
+}
+
+double InputQueue::GetNextRepeatTime() const
+{
+    return m_ShiftAction >= 0 ? m_NextRepeatTime : -1.0;
+}
+
+uint8_t InputQueue::GetHeldInput() const
+{
+    return m_Held[ActionSoftDrop] ? s_ActionInputs[ActionSoftDrop] : 0;
+}
+
+void InputQueue::StartShift(Action action, double time)
+{
+    m_ShiftAction = action;
+    m_NextRepeatTime = time + m_Settings.DelayedAutoShift;
+}
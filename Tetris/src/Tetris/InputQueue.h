@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Key events timestamped by the key callback and consumed by the simulation one tick at a time. A tick only sees the
+// events that happened before its end, so a press and release between two frames still reach the game and movement
+// repeat runs on event time (delayed auto shift and auto repeat rate) instead of the render frame rate
+class InputQueue
+{
+public:
+    enum Action : uint8_t
+    {
+        ActionLeft,
+        ActionRight,
+        ActionRotate,
+        ActionSoftDrop,
+        ActionCount
+    };
+
+    struct Settings
+    {
+        double DelayedAutoShift = 0.167;    // seconds a direction has to be held before it repeats
+        double AutoRepeatRate = 0.033;      // seconds between repeats, 0 repeats on every tick
+    };
+
+    // Time from a press to the simulation tick that applied it
+    struct LatencyStats
+    {
+        uint32_t Presses;
+        double TotalLatency;
+        double MaxLatency;
+    };
+
+public:
+    InputQueue(const Settings& settings);
+
+public:
+    // time is in seconds on the same clock as ConsumeTick
+    void Push(Action action, bool pressed, double time);
+
+    // Game::Input bits of the tick ending at tickEndTime, now is the current time (latency measurement only)
+    uint8_t ConsumeTick(double tickEndTime, double now);
+
+    bool HasPendingEvents() const { return m_EventBegin < m_Events.size(); }
+    // Time of the next auto repeat, a negative value when no direction is held
+    double GetNextRepeatTime() const;
+    // Inputs that stay set while keys are held (soft drop)
+    uint8_t GetHeldInput() const;
+
+    const LatencyStats& GetLatencyStats() const { return m_LatencyStats; }
+    void ResetLatencyStats() { m_LatencyStats = LatencyStats(); }
+
+private:
+    struct Event
+    {
+        double Time;
+        Action Type;
+        bool Pressed;
+    };
+
+    Settings m_Settings;
+
+    std::vector<Event> m_Events;
+    uint32_t m_EventBegin;
+
+    bool m_Held[ActionCount];
+    // Direction that currently shifts, the most recently pressed of the held directions
+    int m_ShiftAction;
+    double m_NextRepeatTime;
+
+    LatencyStats m_LatencyStats;
+
+private:
+    void StartShift(Action action, double time);
+};
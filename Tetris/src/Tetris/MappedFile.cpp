@@ -0,0 +1,108 @@
+#include "MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : m_Data(nullptr), m_Size(0)
+#ifdef _WIN32
+    , m_FileHandle(INVALID_HANDLE_VALUE), m_MappingHandle(nullptr)
+#endif
+{}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+#ifdef _WIN32
+    m_FileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_FileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_FileHandle, &size) || size.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+
+    m_MappingHandle = CreateFileMappingA(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_MappingHandle)
+        m_Data = (const uint8_t*)MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+    m_Size = size.QuadPart;
+#else
+    int fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+        return false;
+
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+    {
+        close(fileDescriptor);
+        return false;
+    }
+
+    void* data = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    // The mapping keeps the file alive on its own
+    close(fileDescriptor);
+
+    if (data != MAP_FAILED)
+        m_Data = (const uint8_t*)data;
+
+    m_Size = fileStatus.st_size;
+#endif
+
+    if (!m_Data)
+    {
+        std::cout << "Failed to map " << path << "!" << std::endl;
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Prefetch(uint64_t offset, uint64_t size) const
+{
+    // Smaller than or equal to the page size of every target
+    const uint64_t pageSize = 4096;
+
+    volatile uint8_t sink = 0;
+    for (uint64_t i = offset; i < offset + size && i < m_Size; i += pageSize)
+        sink += m_Data[i];
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_MappingHandle)
+        CloseHandle(m_MappingHandle);
+    if (m_FileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(m_FileHandle);
+
+    m_FileHandle = INVALID_HANDLE_VALUE;
+    m_MappingHandle = nullptr;
+#else
+    if (m_Data)
+        munmap((void*)m_Data, m_Size);
+#endif
+
+    m_Data = nullptr;
+    m_Size = 0;
+}
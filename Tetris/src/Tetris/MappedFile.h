@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Read only mapping of a whole file, the OS pages the data in on first access instead of copying it up front
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+    bool Open(const std::string& path);
+    void Close();
+
+    // Reads one byte of every page in the range, so that the page faults happen now (e.g. on a loader thread)
+    // instead of in a later reader like a texture upload
+    void Prefetch(uint64_t offset, uint64_t size) const;
+
+    const uint8_t* GetData() const { return m_Data; }
+    uint64_t GetSize() const { return m_Size; }
+
+private:
+    const uint8_t* m_Data;
+    uint64_t m_Size;
+
+#ifdef _WIN32
+    void* m_FileHandle;
+    void* m_MappingHandle;
+#endif
+};
@@ -0,0 +1,288 @@
+#include "Profiler.h"
+
+#ifdef TETRIS_PROFILE
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include <glad/glad.h>
+
+Profiler& Profiler::Get()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler()
+    : m_StartTimepoint(std::chrono::steady_clock::now()), m_FrameStart(0.0), m_InFrame(false), m_FrameIndex(0),
+      m_FirstTraceEvent(true), m_QueryIDs(), m_Queries(), m_FrameQueryCount(0), m_DroppedQueryCount(0), m_GpuReady(false)
+{
+    m_Frames = { "Frame", false, 0.0f, false, std::vector<float>(HistoryFrameCount), 0 };
+    m_Zones.reserve(32);
+}
+
+bool Profiler::BeginTrace(const std::string& path)
+{
+    m_TraceStream.open(path);
+
+    if (!m_TraceStream.is_open())
+    {
+        std::cout << "Failed to open trace file " << path << "!" << std::endl;
+        return false;
+    }
+
+    m_TraceStream << "{\"otherData\": {}, \"traceEvents\": [";
+    m_TraceStream << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 0, \"args\": {\"name\": \"CPU\"}},";
+    m_TraceStream << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 1, \"args\": {\"name\": \"GPU\"}}";
+    m_FirstTraceEvent = false;
+
+    return true;
+}
+
+void Profiler::EndTrace()
+{
+    if (!m_TraceStream.is_open())
+        return;
+
+    m_TraceStream << "]}" << std::endl;
+    m_TraceStream.close();
+}
+
+void Profiler::InitGpu()
+{
+    glGenQueries(GpuFrameLatency * MaxGpuZonesPerFrame, m_QueryIDs);
+    m_GpuReady = true;
+}
+
+void Profiler::ShutdownGpu()
+{
+    if (!m_GpuReady)
+        return;
+
+    CollectGpuQueries(true);
+    glDeleteQueries(GpuFrameLatency * MaxGpuZonesPerFrame, m_QueryIDs);
+    m_GpuReady = false;
+}
+
+void Profiler::BeginFrame()
+{
+    m_FrameStart = GetTime();
+    m_InFrame = true;
+    m_FrameQueryCount = 0;
+
+    for (ZoneHistory& zone : m_Zones)
+    {
+        zone.FrameTotal = 0.0f;
+        zone.InFrame = false;
+    }
+
+    if (m_GpuReady)
+        CollectGpuQueries(false);
+}
+
+void Profiler::EndFrame()
+{
+    double duration = GetTime() - m_FrameStart;
+
+    AddSample(m_Frames, (float)duration);
+    WriteTraceEvent("Frame", m_FrameStart, duration, 0);
+
+    // Zones that ran in this frame contribute their summed time
+    for (ZoneHistory& zone : m_Zones)
+    {
+        if (zone.InFrame && !zone.Gpu)
+            AddSample(zone, zone.FrameTotal);
+    }
+
+    m_InFrame = false;
+    m_FrameIndex++;
+}
+
+double Profiler::GetTime() const
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_StartTimepoint).count();
+}
+
+void Profiler::RecordZone(const char* name, double start, double duration)
+{
+    WriteTraceEvent(name, start, duration, 0);
+
+    if (!m_InFrame)
+        return;
+
+    ZoneHistory& zone = GetZone(name, false);
+    zone.FrameTotal += (float)duration;
+    zone.InFrame = true;
+}
+
+uint32_t Profiler::BeginGpuZone(const char* name, double start)
+{
+    if (!m_GpuReady || m_FrameQueryCount == MaxGpuZonesPerFrame)
+        return UINT32_MAX;
+
+    uint32_t query = (uint32_t)(m_FrameIndex % GpuFrameLatency) * MaxGpuZonesPerFrame + m_FrameQueryCount++;
+
+    m_Queries[query] = { name, start, true };
+    glBeginQuery(GL_TIME_ELAPSED, m_QueryIDs[query]);
+
+    return query;
+}
+
+void Profiler::EndGpuZone(uint32_t query)
+{
+    if (query != UINT32_MAX)
+        glEndQuery(GL_TIME_ELAPSED);
+}
+
+void Profiler::CollectGpuQueries(bool dropPending)
+{
+    // The slots of this frame are reused now, whatever is still pending there is dropped
+    uint32_t reusedSlot = (uint32_t)(m_FrameIndex % GpuFrameLatency);
+
+    for (uint32_t slot = 0; slot < GpuFrameLatency; slot++)
+    {
+        GpuQuery* queries = &m_Queries[slot * MaxGpuZonesPerFrame];
+        const uint32_t* queryIDs = &m_QueryIDs[slot * MaxGpuZonesPerFrame];
+
+        // A zone can run several times in a frame, like the CPU zones its sample is the sum of the frame, so the
+        // queries of a frame are only read once all of them are available
+        uint32_t pendingCount = 0;
+        bool available = true;
+
+        for (uint32_t i = 0; i < MaxGpuZonesPerFrame; i++)
+        {
+            if (!queries[i].Pending)
+                continue;
+
+            GLint queryAvailable = 0;
+            glGetQueryObjectiv(queryIDs[i], GL_QUERY_RESULT_AVAILABLE, &queryAvailable);
+
+            pendingCount++;
+            available = available && queryAvailable;
+        }
+
+        if (pendingCount == 0)
+            continue;
+
+        if (!available)
+        {
+            if (dropPending || slot == reusedSlot)
+            {
+                for (uint32_t i = 0; i < MaxGpuZonesPerFrame; i++)
+                    queries[i].Pending = false;
+
+                m_DroppedQueryCount += pendingCount;
+            }
+
+            continue;
+        }
+
+        for (ZoneHistory& zone : m_Zones)
+        {
+            if (zone.Gpu)
+            {
+                zone.FrameTotal = 0.0f;
+                zone.InFrame = false;
+            }
+        }
+
+        for (uint32_t i = 0; i < MaxGpuZonesPerFrame; i++)
+        {
+            GpuQuery& query = queries[i];
+
+            if (!query.Pending)
+                continue;
+
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(queryIDs[i], GL_QUERY_RESULT, &nanoseconds);
+            query.Pending = false;
+
+            // TIME_ELAPSED has no GPU start time, the event is placed where the CPU issued the commands
+            double duration = nanoseconds / 1000.0;
+            WriteTraceEvent(query.Name, query.Start, duration, 1);
+
+            ZoneHistory& zone = GetZone(query.Name, true);
+            zone.FrameTotal += (float)duration;
+            zone.InFrame = true;
+        }
+
+        for (ZoneHistory& zone : m_Zones)
+        {
+            if (zone.Gpu && zone.InFrame)
+                AddSample(zone, zone.FrameTotal);
+        }
+    }
+}
+
+Profiler::ZoneHistory& Profiler::GetZone(const char* name, bool gpu)
+{
+    // Zone names are string literals, the pointer compare almost always hits first
+    for (ZoneHistory& zone : m_Zones)
+    {
+        if (zone.Gpu == gpu && (zone.Name == name || std::strcmp(zone.Name, name) == 0))
+            return zone;
+    }
+
+    m_Zones.push_back({ name, gpu, 0.0f, false, std::vector<float>(HistoryFrameCount), 0 });
+    return m_Zones.back();
+}
+
+void Profiler::AddSample(ZoneHistory& zone, float value)
+{
+    zone.Samples[zone.NextSample % HistoryFrameCount] = value;
+    zone.NextSample++;
+}
+
+void Profiler::WriteTraceEvent(const char* name, double start, double duration, uint32_t threadID)
+{
+    if (!m_TraceStream.is_open())
+        return;
+
+    if (!m_FirstTraceEvent)
+        m_TraceStream << ",";
+
+    m_TraceStream << "\n{\"name\": \"" << name << "\", \"cat\": \"" << (threadID == 0 ? "cpu" : "gpu")
+                  << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << threadID << std::fixed << std::setprecision(3)
+                  << ", \"ts\": " << start << ", \"dur\": " << duration << "}";
+
+    m_FirstTraceEvent = false;
+}
+
+void Profiler::PrintReport()
+{
+    auto print = [](const ZoneHistory& zone)
+    {
+        uint32_t count = std::min(zone.NextSample, HistoryFrameCount);
+        if (count == 0)
+            return;
+
+        std::vector<float> samples(zone.Samples.begin(), zone.Samples.begin() + count);
+
+        auto percentile = [&samples](double fraction)
+        {
+            size_t index = std::min(samples.size() - 1, (size_t)(fraction * samples.size()));
+            std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+            return samples[index];
+        };
+
+        float p50 = percentile(0.50);
+        float p99 = percentile(0.99);
+        float max = *std::max_element(samples.begin(), samples.end());
+
+        std::cout << "profile " << (zone.Gpu ? "gpu" : "cpu") << " zone=" << zone.Name << " frames=" << count
+                  << std::fixed << std::setprecision(1)
+                  << " p50_us=" << p50 << " p99_us=" << p99 << " max_us=" << max << std::endl;
+    };
+
+    print(m_Frames);
+
+    for (const ZoneHistory& zone : m_Zones)
+        print(zone);
+
+    if (m_DroppedQueryCount)
+        std::cout << "profile gpu dropped_queries=" << m_DroppedQueryCount << std::endl;
+}
+
+#endif
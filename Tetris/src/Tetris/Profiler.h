@@ -0,0 +1,148 @@
+#pragma once
+
+// Frame profiler, only built when TETRIS_PROFILE is defined (Debug configuration), otherwise every PROFILE_ macro
+// expands to nothing and none of the code below exists
+//
+//  PROFILE_SCOPE("Name")       CPU time of the enclosing scope
+//  PROFILE_GPU_SCOPE("Name")   CPU time plus GPU time of the GL commands issued in the scope (GL_TIME_ELAPSED),
+//                              GPU scopes must not nest
+//  PROFILE_BEGIN_FRAME() / PROFILE_END_FRAME() delimit a frame, zones are summed per frame for the p50/p99 report
+
+#ifdef TETRIS_PROFILE
+
+#include <cstdint>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class Profiler
+{
+public:
+    // Query results are read this many frames after they were issued, a result that is still not available then
+    // is dropped instead of waiting for the GPU
+    static constexpr uint32_t GpuFrameLatency = 4;
+    static constexpr uint32_t MaxGpuZonesPerFrame = 16;
+    // Frames kept for the percentiles of every zone
+    static constexpr uint32_t HistoryFrameCount = 4096;
+
+public:
+    static Profiler& Get();
+
+public:
+    // Streams every zone into a Chrome trace_event JSON file (chrome://tracing, Perfetto)
+    bool BeginTrace(const std::string& path);
+    void EndTrace();
+
+    // Query objects need a current GL context
+    void InitGpu();
+    void ShutdownGpu();
+
+    void BeginFrame();
+    void EndFrame();
+
+    // Microseconds since the profiler was created
+    double GetTime() const;
+
+    void RecordZone(const char* name, double start, double duration);
+    uint32_t BeginGpuZone(const char* name, double start);
+    void EndGpuZone(uint32_t query);
+
+    // p50, p99 and max of every zone and of the whole frame
+    void PrintReport();
+
+private:
+    struct ZoneHistory
+    {
+        const char* Name;
+        bool Gpu;
+        float FrameTotal;
+        bool InFrame;
+        std::vector<float> Samples;
+        uint32_t NextSample;
+    };
+
+    struct GpuQuery
+    {
+        const char* Name;
+        double Start;
+        bool Pending;
+    };
+
+    std::chrono::steady_clock::time_point m_StartTimepoint;
+
+    std::vector<ZoneHistory> m_Zones;
+    ZoneHistory m_Frames;
+    double m_FrameStart;
+    bool m_InFrame;
+    uint64_t m_FrameIndex;
+
+    std::ofstream m_TraceStream;
+    bool m_FirstTraceEvent;
+
+    uint32_t m_QueryIDs[GpuFrameLatency * MaxGpuZonesPerFrame];
+    GpuQuery m_Queries[GpuFrameLatency * MaxGpuZonesPerFrame];
+    uint32_t m_FrameQueryCount;
+    uint64_t m_DroppedQueryCount;
+    bool m_GpuReady;
+
+private:
+    Profiler();
+
+    ZoneHistory& GetZone(const char* name, bool gpu);
+    static void AddSample(ZoneHistory& zone, float value);
+    void WriteTraceEvent(const char* name, double start, double duration, uint32_t threadID);
+    void CollectGpuQueries(bool dropPending);
+};
+
+class ProfileScope
+{
+public:
+    ProfileScope(const char* name)
+        : m_Name(name), m_Start(Profiler::Get().GetTime())
+    {}
+
+    ~ProfileScope()
+    {
+        Profiler& profiler = Profiler::Get();
+        profiler.RecordZone(m_Name, m_Start, profiler.GetTime() - m_Start);
+    }
+
+private:
+    const char* m_Name;
+    double m_Start;
+};
+
+class GpuProfileScope
+{
+public:
+    GpuProfileScope(const char* name)
+        : m_CpuScope(name), m_Query(Profiler::Get().BeginGpuZone(name, Profiler::Get().GetTime()))
+    {}
+
+    ~GpuProfileScope()
+    {
+        Profiler::Get().EndGpuZone(m_Query);
+    }
+
+private:
+    ProfileScope m_CpuScope;
+    uint32_t m_Query;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#define PROFILE_BEGIN_FRAME() Profiler::Get().BeginFrame()
+#define PROFILE_END_FRAME() Profiler::Get().EndFrame()
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name)
+#define PROFILE_BEGIN_FRAME()
+#define PROFILE_END_FRAME()
+
+#endif
@@ -0,0 +1,326 @@
+#include "ShaderManager.h"
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+
+#ifdef _WIN32
+    #include <direct.h>
+#else
+    #include <sys/stat.h>
+#endif
+
+#include "GLState.h"
+#include "MappedFile.h"
+
+// ARB_get_program_binary (core since 4.1) and KHR_parallel_shader_compile, not part of the GL 3.3 loader
+static constexpr GLenum ProgramBinaryRetrievableHint = 0x8257;
+static constexpr GLenum ProgramBinaryLength = 0x8741;
+static constexpr GLenum NumProgramBinaryFormats = 0x87FE;
+
+// Cache file: this header followed by the binary returned by glGetProgramBinary
+static constexpr uint32_t ShaderCacheMagic = 0x48534C47;     // "GLSH"
+
+struct ShaderCacheHeader
+{
+    uint32_t Magic;
+    uint32_t BinaryFormat;
+    uint64_t Hash;
+    uint64_t BinarySize;
+};
+
+static double GetMilliseconds(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+ShaderManager::ShaderManager(const std::string& cacheDirectory, GLADloadproc getProcAddress)
+    : m_CacheDirectory(cacheDirectory), m_GetProgramBinary(nullptr), m_ProgramBinary(nullptr), m_ProgramParameteri(nullptr), m_MaxShaderCompilerThreads(nullptr)
+{
+    // A driver update invalidates the binaries, it changes at least one of these
+    m_DriverString = std::string((const char*)glGetString(GL_VENDOR)) + "|" + (const char*)glGetString(GL_RENDERER) + "|" + (const char*)glGetString(GL_VERSION);
+
+    GLint majorVersion = 0, minorVersion = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+
+    if (majorVersion > 4 || (majorVersion == 4 && minorVersion >= 1) || IsExtensionSupported("GL_ARB_get_program_binary"))
+    {
+        // Some drivers have the entry points but no format to store programs in
+        GLint formatCount = 0;
+        glGetIntegerv(NumProgramBinaryFormats, &formatCount);
+
+        if (formatCount > 0)
+        {
+            m_GetProgramBinary = (GetProgramBinaryFunction)getProcAddress("glGetProgramBinary");
+            m_ProgramBinary = (ProgramBinaryFunction)getProcAddress("glProgramBinary");
+            m_ProgramParameteri = (ProgramParameteriFunction)getProcAddress("glProgramParameteri");
+        }
+    }
+
+    if (IsExtensionSupported("GL_KHR_parallel_shader_compile"))
+        m_MaxShaderCompilerThreads = (MaxShaderCompilerThreadsFunction)getProcAddress("glMaxShaderCompilerThreadsKHR");
+    else if (IsExtensionSupported("GL_ARB_parallel_shader_compile"))
+        m_MaxShaderCompilerThreads = (MaxShaderCompilerThreadsFunction)getProcAddress("glMaxShaderCompilerThreadsARB");
+
+    // As many threads as the driver sees fit
+    if (m_MaxShaderCompilerThreads)
+        m_MaxShaderCompilerThreads(0xFFFFFFFF);
+
+    if (HasProgramBinaries())
+    {
+#ifdef _WIN32
+        _mkdir(m_CacheDirectory.c_str());
+#else
+        mkdir(m_CacheDirectory.c_str(), 0755);
+#endif
+    }
+}
+
+ShaderManager::~ShaderManager()
+{
+    for (const Program& program : m_Programs)
+    {
+        glDeleteShader(program.VertexShaderID);
+        glDeleteShader(program.FragmentShaderID);
+        glDeleteProgram(program.ID);
+    }
+}
+
+void ShaderManager::Load(const std::string& name, const std::string& vertexSource, const std::string& fragmentSource)
+{
+    auto startTimepoint = std::chrono::high_resolution_clock::now();
+
+    Program program = {};
+    program.Name = name;
+    program.VertexSource = vertexSource;
+    program.FragmentSource = fragmentSource;
+    program.Hash = Hash(fragmentSource, Hash(vertexSource, Hash(m_DriverString)));
+    program.ID = glCreateProgram();
+    program.Pending = true;
+
+    // Nothing is waited for here, a rejected binary shows up as a link failure in Finish
+    program.FromBinary = HasProgramBinaries() && LoadBinary(program);
+    if (!program.FromBinary)
+        Compile(program);
+
+    program.IssueTime = GetMilliseconds(startTimepoint);
+    m_Programs.push_back(program);
+}
+
+bool ShaderManager::Finish()
+{
+    auto startTimepoint = std::chrono::high_resolution_clock::now();
+
+    bool success = true;
+    uint32_t programCount = 0;
+    uint32_t binaryCount = 0;
+    double issueTime = 0.0;
+
+    for (Program& program : m_Programs)
+    {
+        if (!program.Pending)
+            continue;
+
+        auto waitTimepoint = std::chrono::high_resolution_clock::now();
+        program.Pending = false;
+
+        // Blocks until this program is done, the others of the batch keep building meanwhile
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program.ID, GL_LINK_STATUS, &linked);
+
+        // Binaries of another driver build are rejected, the program is compiled from source then
+        if (!linked && program.FromBinary)
+        {
+            std::cout << "Cached shader program " << program.Name << " was rejected, compiling it" << std::endl;
+
+            program.FromBinary = false;
+            Compile(program);
+            glGetProgramiv(program.ID, GL_LINK_STATUS, &linked);
+        }
+
+        if (program.VertexShaderID)
+        {
+            bool compiled = CheckShader(program, program.VertexShaderID, "vertex");
+            compiled = CheckShader(program, program.FragmentShaderID, "fragment") && compiled;
+
+            glDetachShader(program.ID, program.VertexShaderID);
+            glDetachShader(program.ID, program.FragmentShaderID);
+            glDeleteShader(program.VertexShaderID);
+            glDeleteShader(program.FragmentShaderID);
+            program.VertexShaderID = 0;
+            program.FragmentShaderID = 0;
+
+            success = success && compiled;
+        }
+
+        if (!linked)
+        {
+            GLint logLength = 0;
+            glGetProgramiv(program.ID, GL_INFO_LOG_LENGTH, &logLength);
+
+            std::string log(logLength > 0 ? logLength : 1, '\0');
+            glGetProgramInfoLog(program.ID, log.size(), nullptr, &log[0]);
+
+            std::cout << "Failed to link shader program " << program.Name << "!\n" << log.c_str() << std::endl;
+            success = false;
+            continue;
+        }
+
+        if (!program.FromBinary && HasProgramBinaries())
+            SaveBinary(program);
+
+        GLState::BindProjectionBlock(program.ID);
+
+        std::cout << "shader program=" << program.Name << " from=" << (program.FromBinary ? "binary" : "source")
+                  << " issue_ms=" << program.IssueTime << " wait_ms=" << GetMilliseconds(waitTimepoint) << std::endl;
+
+        programCount++;
+        binaryCount += program.FromBinary;
+        issueTime += program.IssueTime;
+    }
+
+    std::cout << "shaders programs=" << programCount << " from_binary=" << binaryCount << " parallel_compile=" << HasParallelCompile()
+              << " binaries=" << HasProgramBinaries() << " ms=" << issueTime + GetMilliseconds(startTimepoint) << std::endl;
+
+    return success;
+}
+
+uint32_t ShaderManager::GetProgram(const std::string& name) const
+{
+    for (const Program& program : m_Programs)
+    {
+        if (program.Name == name)
+            return program.ID;
+    }
+
+    std::cout << "Shader program " << name << " was never loaded!" << std::endl;
+    return 0;
+}
+
+void ShaderManager::Compile(Program& program)
+{
+    program.VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+    program.FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+
+    const char* source = program.VertexSource.c_str();
+    glShaderSource(program.VertexShaderID, 1, &source, nullptr);
+    source = program.FragmentSource.c_str();
+    glShaderSource(program.FragmentShaderID, 1, &source, nullptr);
+
+    glCompileShader(program.VertexShaderID);
+    glCompileShader(program.FragmentShaderID);
+
+    glAttachShader(program.ID, program.VertexShaderID);
+    glAttachShader(program.ID, program.FragmentShaderID);
+
+    if (m_ProgramParameteri)
+        m_ProgramParameteri(program.ID, ProgramBinaryRetrievableHint, GL_TRUE);
+
+    glLinkProgram(program.ID);
+}
+
+bool ShaderManager::LoadBinary(Program& program)
+{
+    MappedFile file;
+    if (!file.Open(GetBinaryPath(program)))
+        return false;
+
+    const ShaderCacheHeader* header = (const ShaderCacheHeader*)file.GetData();
+
+    // Hash collisions of the file name are caught by the full hash in the header
+    if (file.GetSize() < sizeof(ShaderCacheHeader) || header->Magic != ShaderCacheMagic || header->Hash != program.Hash
+        || header->BinarySize != file.GetSize() - sizeof(ShaderCacheHeader))
+        return false;
+
+    m_ProgramBinary(program.ID, header->BinaryFormat, file.GetData() + sizeof(ShaderCacheHeader), header->BinarySize);
+    return true;
+}
+
+void ShaderManager::SaveBinary(const Program& program)
+{
+    GLint length = 0;
+    glGetProgramiv(program.ID, ProgramBinaryLength, &length);
+
+    if (length <= 0)
+        return;
+
+    std::vector<uint8_t> binary(length);
+    GLenum binaryFormat = 0;
+    m_GetProgramBinary(program.ID, length, &length, &binaryFormat, binary.data());
+
+    ShaderCacheHeader header = { ShaderCacheMagic, binaryFormat, program.Hash, (uint64_t)length };
+
+    // Written next to the final file and renamed, a concurrently starting instance never maps half a file
+    std::string path = GetBinaryPath(program);
+    std::string temporaryPath = path + ".tmp";
+
+    {
+        std::ofstream outputStream(temporaryPath, std::ios::binary);
+        outputStream.write((const char*)&header, sizeof(header));
+        outputStream.write((const char*)binary.data(), length);
+
+        if (!outputStream)
+        {
+            std::cout << "Failed to write " << temporaryPath << "!" << std::endl;
+            return;
+        }
+    }
+
+    std::remove(path.c_str());
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+        std::cout << "Failed to write " << path << "!" << std::endl;
+}
+
+bool ShaderManager::CheckShader(const Program& program, uint32_t shaderID, const char* stage)
+{
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &compiled);
+
+    if (compiled)
+        return true;
+
+    GLint logLength = 0;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+
+    std::string log(logLength > 0 ? logLength : 1, '\0');
+    glGetShaderInfoLog(shaderID, log.size(), nullptr, &log[0]);
+
+    std::cout << "Failed to compile " << stage << " shader of " << program.Name << "!\n" << log.c_str() << std::endl;
+    return false;
+}
+
+std::string ShaderManager::GetBinaryPath(const Program& program) const
+{
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "%016llx.bin", (unsigned long long)program.Hash);
+
+    return m_CacheDirectory + "/" + fileName;
+}
+
+bool ShaderManager::IsExtensionSupported(const char* extension)
+{
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+    for (GLint i = 0; i < extensionCount; i++)
+    {
+        if (std::string((const char*)glGetStringi(GL_EXTENSIONS, i)) == extension)
+            return true;
+    }
+
+    return false;
+}
+
+uint64_t ShaderManager::Hash(const std::string& text, uint64_t hash)
+{
+    // FNV-1a
+    for (char character : text)
+    {
+        hash ^= (uint8_t)character;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
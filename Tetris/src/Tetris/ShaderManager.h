@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+
+// Builds every shader program of the game in one batch and owns them. Load only issues the work (compile and link
+// from GLSL, or a program binary cached by an earlier run), Finish waits for all of it, checks the status and logs
+// the errors. Drivers with KHR_parallel_shader_compile build the programs of a batch concurrently. Linked programs are
+// written to the cache directory with glGetProgramBinary, keyed by a hash of the sources and the driver strings, so
+// warm starts skip GLSL compilation
+class ShaderManager
+{
+public:
+    // getProcAddress loads the program binary and parallel compile entry points, the GL 3.3 loader lacks them
+    ShaderManager(const std::string& cacheDirectory, GLADloadproc getProcAddress);
+    ~ShaderManager();
+
+    ShaderManager(const ShaderManager&) = delete;
+    ShaderManager& operator=(const ShaderManager&) = delete;
+
+public:
+    void Load(const std::string& name, const std::string& vertexSource, const std::string& fragmentSource);
+    // Returns false if a program failed to build, the errors were printed
+    bool Finish();
+
+    // 0 for unknown names, programs are usable once Finish returned
+    uint32_t GetProgram(const std::string& name) const;
+
+    bool HasProgramBinaries() const { return m_GetProgramBinary && m_ProgramBinary; }
+    bool HasParallelCompile() const { return m_MaxShaderCompilerThreads != nullptr; }
+
+private:
+    using GetProgramBinaryFunction = void (APIENTRYP)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    using ProgramBinaryFunction = void (APIENTRYP)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+    using ProgramParameteriFunction = void (APIENTRYP)(GLuint program, GLenum pname, GLint value);
+    using MaxShaderCompilerThreadsFunction = void (APIENTRYP)(GLuint count);
+
+    struct Program
+    {
+        std::string Name;
+        std::string VertexSource;
+        std::string FragmentSource;
+        uint64_t Hash;
+
+        uint32_t ID;
+        uint32_t VertexShaderID;        // 0 when built from a binary
+        uint32_t FragmentShaderID;
+        bool Pending;
+        bool FromBinary;
+        double IssueTime;               // milliseconds spent issuing the GL calls
+    };
+
+    std::string m_CacheDirectory;
+    std::string m_DriverString;
+    std::vector<Program> m_Programs;
+
+    GetProgramBinaryFunction m_GetProgramBinary;
+    ProgramBinaryFunction m_ProgramBinary;
+    ProgramParameteriFunction m_ProgramParameteri;
+    MaxShaderCompilerThreadsFunction m_MaxShaderCompilerThreads;
+
+private:
+    void Compile(Program& program);
+    bool LoadBinary(Program& program);
+    void SaveBinary(const Program& program);
+    bool CheckShader(const Program& program, uint32_t shaderID, const char* stage);
+    std::string GetBinaryPath(const Program& program) const;
+
+    static bool IsExtensionSupported(const char* extension);
+    static uint64_t Hash(const std::string& text, uint64_t hash = 14695981039346656037ull);
+};
@@ -3,22 +3,236 @@
 #include <fstream>
 #include <sstream>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "FontFile.h"
+#include "Profiler.h"
+
+Font::Font()
+    : m_Texels(nullptr), m_TextureWidth(0), m_TextureHeight(0), m_TextureChannelCount(0), m_DistanceRange(0.0f),
+      m_TextureID(0), m_TextureReferenceCount(0), m_TextureBytes(0)
+{
+    BuildLookup();
+}
+
 Font::Font(const std::string& fontFilePath, const std::string& fontTextruresPath)
-    : m_TexturesPath(fontTextruresPath)
+    : Font()
+{
+    Load(fontFilePath, fontTextruresPath);
+}
+
+Font::~Font()
 {
+    if (m_TextureReferenceCount)
+        std::cout << "Font destroyed while " << m_TextureReferenceCount << " text renderers still use it!" << std::endl;
+
+    glDeleteTextures(1, &m_TextureID);
+}
+
+uint32_t Font::AcquireTexture() const
+{
+    if (m_TextureReferenceCount++ == 0)
+        UploadTexture();
+
+    return m_TextureID;
+}
+
+void Font::UploadTexture() const
+{
+    if (m_TextureID == 0)
+        CreateTexture();
+}
+
+void Font::ReleaseTexture() const
+{
+    if (m_TextureReferenceCount == 0 || --m_TextureReferenceCount > 0)
+        return;
+
+    glDeleteTextures(1, &m_TextureID);
+    m_TextureID = 0;
+    m_TextureBytes = 0;
+}
+
+bool Font::Load(const std::string& fontFilePath, const std::string& fontTextruresPath)
+{
+    m_Characters.clear();
+    m_BakedFile.Close();
+    m_DecodedTexels.clear();
+    m_Texels = nullptr;
+    m_DistanceRange = 0.0f;
+    m_TexturesPath = fontTextruresPath;
+
     ParseFondFile(fontFilePath, m_Characters);
+    bool loaded = !m_Characters.empty();
+
+    if (!loaded)
+        std::cout << "Failed to load font " << fontFilePath << "!" << std::endl;
+
+    BuildLookup();
+
+    // Decoded here rather than when the texture is created, which has to happen on the GL thread. Loads run on the
+    // asset workers, so the flip is set for this thread only
+    stbi_set_flip_vertically_on_load_thread(1);
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(m_TexturesPath.c_str(), &width, &height, &channels, 4);
+
+    if (pixels)
+    {
+        m_DecodedTexels.assign(pixels, pixels + (uint64_t)width * height * 4);
+        m_Texels = m_DecodedTexels.data();
+        m_TextureWidth = width;
+        m_TextureHeight = height;
+        m_TextureChannelCount = 4;
+
+        stbi_image_free(pixels);
+    }
+    else
+    {
+        std::cout << "Failed to load font texture " << m_TexturesPath << "!" << std::endl;
+        loaded = false;
+    }
+
+    return loaded;
+}
+
+bool Font::LoadBaked(const std::string& bakedFontPath)
+{
+    m_DecodedTexels.clear();
+    m_Texels = nullptr;
+
+    // The texels stay mapped for as long as the font lives
+    MappedFile& file = m_BakedFile;
+    if (!file.Open(bakedFontPath))
+    {
+        std::cout << "Failed to open baked font " << bakedFontPath << "!" << std::endl;
+        return false;
+    }
+
+    static_assert(sizeof(Character) == sizeof(FontFileGlyph), "Font::Character and FontFileGlyph must have the same layout");
+
+    const FontFileHeader* header = (const FontFileHeader*)file.GetData();
+    uint64_t glyphEnd = file.GetSize() >= sizeof(FontFileHeader) ? header->GlyphOffset + (uint64_t)header->GlyphCount * sizeof(FontFileGlyph) : 0;
+
+    if (file.GetSize() < sizeof(FontFileHeader) || header->Magic != FontFileMagic || header->Version != FontFileVersion || header->GlyphCount == 0
+        || glyphEnd > file.GetSize() || header->TexelOffset < glyphEnd || header->TexelOffset + header->TexelSize > file.GetSize()
+        || header->TexelSize != (uint64_t)header->TextureWidth * header->TextureHeight * header->ChannelCount
+        || (header->ChannelCount != 1 && header->ChannelCount != 4)
+        || ((header->Flags & FontFileFlagDistanceField) && (header->ChannelCount != 1 || header->DistanceRange <= 0.0f)))
+    {
+        std::cout << bakedFontPath << " is not a baked font of version " << FontFileVersion << "!" << std::endl;
+        file.Close();
+        return false;
+    }
+
+    m_Characters.resize(header->GlyphCount);
+    std::memcpy(m_Characters.data(), file.GetData() + header->GlyphOffset, header->GlyphCount * sizeof(FontFileGlyph));
+    BuildLookup();
+
+    m_TexturesPath.clear();
+    m_Texels = file.GetData() + header->TexelOffset;
+    file.Prefetch(header->TexelOffset, header->TexelSize);
+    m_TextureWidth = header->TextureWidth;
+    m_TextureHeight = header->TextureHeight;
+    m_TextureChannelCount = header->ChannelCount;
+    m_DistanceRange = (header->Flags & FontFileFlagDistanceField) ? header->DistanceRange : 0.0f;
+
+    return true;
 }
 
-const Font::Character& Font::GetCharacter(uint32_t charID) const
+const Font::Character& Font::FindCharacter(uint32_t charID) const
 {
+    if (!m_HashedCharacters.empty())
+    {
+        uint32_t mask = m_HashedCharacters.size() - 1;
+
+        for (uint32_t slot = HashCharID(charID) & mask; m_HashedCharacters[slot].Index != NoCharacter; slot = (slot + 1) & mask)
+        {
+            if (m_HashedCharacters[slot].CharID == charID)
+                return m_Characters[m_HashedCharacters[slot].Index];
+        }
+    }
+
+    std::cout << "Character not defined" << std::endl;
+    return m_Characters[0];
+}
+
+void Font::BuildLookup()
+{
+    // A font that failed to load still has one blank character to fall back to
+    if (m_Characters.empty())
+        m_Characters.push_back(Character());
+
+    uint32_t hashedCount = 0;
+    m_HashedCharacters.clear();
+
+    for (uint32_t i = 0; i < DirectCharacterCount; i++)
+        m_DirectCharacters[i] = NoCharacter;
+
+    for (uint32_t i = 0; i < m_Characters.size(); i++)
+    {
+        if (m_Characters[i].charID < DirectCharacterCount)
+            m_DirectCharacters[m_Characters[i].charID] = i;
+        else
+            hashedCount++;
+    }
+
+    if (hashedCount == 0)
+        return;
+
+    // At most half full so that probe sequences stay short
+    uint32_t size = 1;
+    while (size < hashedCount * 2)
+        size *= 2;
+
+    m_HashedCharacters.assign(size, { 0, NoCharacter });
+
     for (uint32_t i = 0; i < m_Characters.size(); i++)
+    {
+        if (m_Characters[i].charID < DirectCharacterCount)
+            continue;
+
+        uint32_t slot = HashCharID(m_Characters[i].charID) & (size - 1);
+        while (m_HashedCharacters[slot].Index != NoCharacter)
+            slot = (slot + 1) & (size - 1);
+
+        m_HashedCharacters[slot] = { m_Characters[i].charID, (uint16_t)i };
+    }
+}
+
+void Font::CreateTexture() const
+{
+    glGenTextures(1, &m_TextureID);
+    glBindTexture(GL_TEXTURE_2D, m_TextureID);
+
+    // Distances interpolate, the outline between two texels is where the shader puts the edge
+    GLint filter = IsDistanceField() ? GL_LINEAR : GL_NEAREST;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    if (m_Texels)
+    {
+        // Texels are already flipped, single channel atlases hold the coverage of white glyphs (or their distance)
+        if (m_TextureChannelCount == 1)
         {
-            if (m_Characters[i].charID == charID)
-                return m_Characters[i];
+            GLint swizzle[] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, m_TextureWidth, m_TextureHeight, 0, GL_RED, GL_UNSIGNED_BYTE, m_Texels);
+            m_TextureBytes = (uint64_t)m_TextureWidth * m_TextureHeight;
         }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_TextureWidth, m_TextureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_Texels);
+            m_TextureBytes = (uint64_t)m_TextureWidth * m_TextureHeight * 4;
+        }
+    }
 
-        std::cout << "Character not defined" << std::endl;
-        return m_Characters[0];
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Font::ParseFondFile(const std::string& fontFilePath, std::vector<Character>& outCharacters)
@@ -29,6 +243,10 @@ void Font::ParseFondFile(const std::string& fontFilePath, std::vector<Character>
     std::stringstream stringStream;
     std::string parameter = "";
 
+    // Size of the atlas, the common line comes before the first char line
+    float textureWidth = 512.0f;
+    float textureHeight = 512.0f;
+
     while (std::getline(fileStream, line))
     {
         stringStream.clear();
@@ -36,223 +254,350 @@ void Font::ParseFondFile(const std::string& fontFilePath, std::vector<Character>
 
         stringStream >> parameter;
 
-        if (parameter == "char")
+        if (parameter == "common")
+        {
+            while (stringStream >> parameter)
+            {
+                if (parameter.compare(0, 7, "scaleW=") == 0)
+                    textureWidth = std::stoi(parameter.substr(7));
+                else if (parameter.compare(0, 7, "scaleH=") == 0)
+                    textureHeight = std::stoi(parameter.substr(7));
+            }
+        }
+        else if (parameter == "char")
         {
             Character character;
 
             stringStream >> parameter;
-            character.charID = std::stof(parameter.substr(parameter.find('=') + 1));
+            character.charID = std::stoul(parameter.substr(parameter.find('=') + 1));
 
             stringStream >> parameter;
-            character.xCoord = std::stof(parameter.substr(parameter.find('=') + 1));
+            character.xCoord = std::stoi(parameter.substr(parameter.find('=') + 1));
 
             stringStream >> parameter;
-            character.yCoord = std::stof(parameter.substr(parameter.find('=') + 1));
+            character.yCoord = std::stoi(parameter.substr(parameter.find('=') + 1));
 
             stringStream >> parameter;
-            character.width = std::stof(parameter.substr(parameter.find('=') + 1));
+            character.width = std::stoi(parameter.substr(parameter.find('=') + 1));
 
             stringStream >> parameter;
-            character.height = std::stof(parameter.substr(parameter.find('=') + 1));
+            character.height = std::stoi(parameter.substr(parameter.find('=') + 1));
 
             stringStream >> parameter;
-            character.xOffset = std::stof(parameter.substr(parameter.find('=') + 1));
+            character.xOffset = std::stoi(parameter.substr(parameter.find('=') + 1));
 
             stringStream >> parameter;
-            character.yOffset = std::stof(parameter.substr(parameter.find('=') + 1));
+            character.yOffset = std::stoi(parameter.substr(parameter.find('=') + 1));
 
             stringStream >> parameter;
-            character.xAdvance = std::stof(parameter.substr(parameter.find('=') + 1));
+            character.xAdvance = std::stoi(parameter.substr(parameter.find('=') + 1));
 
-            m_Characters.push_back(character);
+            // The atlas is loaded flipped, v grows upwards from the last row of the file
+            character.u0 = character.xCoord / textureWidth;
+            character.v0 = (textureHeight - character.yCoord) / textureHeight;
+            character.u1 = (character.xCoord + character.width) / textureWidth;
+            character.v1 = (textureHeight - character.yCoord - character.height) / textureHeight;
+
+            outCharacters.push_back(character);
         }
     }
 }
 
 
 
-TextField::TextField(const glm::vec2& position, float scale, const std::string& text, const Font& font)
-    : m_ModelMatrix(1.0f), m_Text(text), m_Font(font), m_VertexBufferID(0), m_IndexBufferID(0), m_VertexArrayID(0), m_TextureID(0)
+// Writes 4 corners (x, y, u, v) per character from the first one on, in font pixels with the cursor starting at the origin
+static void LayoutText(const Font& font, const char* text, uint32_t length, uint32_t first, float* vertices)
 {
-    m_ModelMatrix = glm::translate(m_ModelMatrix, glm::vec3(position.x, position.y, 0.0f));
-    m_ModelMatrix = glm::scale(m_ModelMatrix, glm::vec3(scale, scale, 1.0f));
+    int32_t cursorOffset = 0;
 
-    float vertices[m_Text.size() * 4 * 4];
-    uint32_t indices[m_Text.size() * 6];
+    // Only the advances of the kept glyphs are needed to find where the first one starts
+    for (uint32_t i = 0; i < first; i++)
+        cursorOffset += font.GetCharacter((uint8_t)text[i]).xAdvance;
 
-    GenerateVerticesAndIndices(vertices, indices);
+    for (uint32_t i = first; i < length; i++)
+    {
+        // The text is Latin-1, char may be signed
+        const Font::Character& character = font.GetCharacter((uint8_t)text[i]);
+
+        float left = (float)(cursorOffset + character.xOffset);
+        float right = (float)(cursorOffset + character.xOffset + character.width);
+        float top = (float)-character.yOffset;
+        float bottom = (float)(-character.yOffset - character.height);
+
+        vertices[i * 16 + 0] = left;
+        vertices[i * 16 + 1] = top;
+        vertices[i * 16 + 2] = character.u0;
+        vertices[i * 16 + 3] = character.v0;
+
+        vertices[i * 16 + 4] = left;
+        vertices[i * 16 + 5] = bottom;
+        vertices[i * 16 + 6] = character.u0;
+        vertices[i * 16 + 7] = character.v1;
+
+        vertices[i * 16 + 8] = right;
+        vertices[i * 16 + 9] = bottom;
+        vertices[i * 16 + 10] = character.u1;
+        vertices[i * 16 + 11] = character.v1;
+
+        vertices[i * 16 + 12] = right;
+        vertices[i * 16 + 13] = top;
+        vertices[i * 16 + 14] = character.u1;
+        vertices[i * 16 + 15] = character.v0;
 
-    glGenBuffers(1, &m_VertexBufferID);
-    glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
-    glBufferData(GL_ARRAY_BUFFER, m_Text.size() * 4 * 4 * sizeof(float), vertices, GL_DYNAMIC_DRAW);
+        cursorOffset += character.xAdvance;
+    }
+}
 
-    glGenBuffers(1, &m_IndexBufferID);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Text.size() * 6 * sizeof(uint32_t), indices, GL_DYNAMIC_DRAW);
 
-    glGenVertexArrays(1, &m_VertexArrayID);
-    glBindVertexArray(m_VertexArrayID);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1 ,2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (const void*)(2 * sizeof(float)));
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+TextField::TextField(const glm::vec2& position, float scale, const std::string& text, const Font& font, const glm::vec4& color, uint32_t capacity)
+    : m_Position(position), m_Scale(scale), m_Color(color), m_Font(font)
+{
+    capacity = std::max<uint32_t>(capacity, text.size());
+    m_Text.reserve(capacity);
+    m_Vertices.reserve(capacity * 16);
 
-    m_TextureID = CreateTexture(m_Font.GetTexturesPath());
+    SetText(text);
 }
 
-TextField::~TextField()
+void TextField::SetText(const char* text, uint32_t length)
 {
-    glDeleteBuffers(1, &m_VertexBufferID);
-    glDeleteBuffers(1, &m_IndexBufferID);
-    glDeleteVertexArrays(1, &m_VertexArrayID);
-    glDeleteTextures(1, &m_TextureID);
-}
+    // The quads in front of the first difference stay valid, they do not depend on what follows
+    uint32_t first = 0;
+    uint32_t sharedLength = std::min<uint32_t>(length, m_Text.size());
+    while (first < sharedLength && m_Text[first] == text[first])
+        first++;
 
-void TextField::SetText(const std::string& text)
-{
-    m_Text = text;
+    if (first == length && length == m_Text.size())
+        return;
 
-    float vertices[m_Text.size() * 4 * 4];
-    uint32_t indices[m_Text.size() * 6];
+    m_Text.assign(text, length);
+    m_Vertices.resize(length * 16);
 
-    GenerateVerticesAndIndices(vertices, indices);
+    LayoutText(m_Font, m_Text.data(), length, first, m_Vertices.data());
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
-    glBufferData(GL_ARRAY_BUFFER, m_Text.size() * 4 * 4 * sizeof(float), vertices, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Text.size() * 6 * sizeof(uint32_t), indices, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+NumericField::NumericField(const glm::vec2& position, float scale, uint64_t value, const Font& font, const glm::vec4& color)
+    : m_TextField(position, scale, "", font, color, MaxDigits), m_Value(~value)
+{
+    SetValue(value);
 }
 
-void TextField::GenerateVerticesAndIndices(float* vertices, uint32_t* indices)
+void NumericField::SetValue(uint64_t value)
 {
-    float cursorOffset = 0;
+    if (value == m_Value)
+        return;
 
-    for (uint32_t i = 0; i < m_Text.size(); i++)
+    m_Value = value;
+
+    char digits[MaxDigits];
+    uint32_t first = MaxDigits;
+
+    do
     {
-        Font::Character character = m_Font.GetCharacter(m_Text[i]);
+        digits[--first] = '0' + value % 10;
+        value /= 10;
+    } while (value);
 
-        vertices[i * 16 + 0] = cursorOffset + character.xOffset;
-        vertices[i * 16 + 1] = 0 - character.yOffset;
-        vertices[i * 16 + 2] = character.xCoord / 512;
-        vertices[i * 16 + 3] = (512 - character.yCoord) / 512;
+    m_TextField.SetText(&digits[first], MaxDigits - first);
+}
 
-        vertices[i * 16 + 4] = cursorOffset + character.xOffset;
-        vertices[i * 16 + 5] = 0 - character.yOffset - character.height;
-        vertices[i * 16 + 6] = character.xCoord / 512;
-        vertices[i * 16 + 7] = (512 - character.yCoord - character.height) / 512;
 
-        vertices[i * 16 + 8] = cursorOffset + character.xOffset + character.width;
-        vertices[i * 16 + 9] = 0 - character.yOffset - character.height;
-        vertices[i * 16 + 10] = (character.xCoord + character.width) / 512;
-        vertices[i * 16 + 11] = (512 - character.yCoord - character.height) / 512;
 
-        vertices[i * 16 + 12] = cursorOffset + character.xOffset + character.width;
-        vertices[i * 16 + 13] = 0 - character.yOffset;
-        vertices[i * 16 + 14] = (character.xCoord + character.width) / 512;
-        vertices[i * 16 + 15] = (512 - character.yCoord) / 512;
+void TextRenderer::LoadShaders(ShaderManager& shaderManager)
+{
+    shaderManager.Load("TextRenderer.Bitmap", s_VertexShaderSource, s_FragmentShaderSource);
+    shaderManager.Load("TextRenderer.DistanceField", s_VertexShaderSource, s_DistanceFieldFragmentShaderSource);
+}
+
+TextRenderer::TextRenderer(GLState& state, const ShaderManager& shaderManager)
+    : m_State(state), m_ShaderID(0), m_DistanceFieldShaderID(0), m_OutlineColorUniformLocation(-1), m_OutlineWidthUniformLocation(-1),
+      m_OutlineColor(0.0f, 0.0f, 0.0f, 1.0f), m_OutlineWidth(0.0f), m_VertexArrayID(0), m_VertexBufferID(0), m_IndexBufferID(0), m_StreamOffset(0)
+{
+    m_ShaderID = shaderManager.GetProgram("TextRenderer.Bitmap");
+    m_DistanceFieldShaderID = shaderManager.GetProgram("TextRenderer.DistanceField");
 
+    m_OutlineColorUniformLocation = glGetUniformLocation(m_DistanceFieldShaderID, "u_OutlineColor");
+    m_OutlineWidthUniformLocation = glGetUniformLocation(m_DistanceFieldShaderID, "u_OutlineWidth");
+
+    // Every batch starts at a vertex offset of the stream buffer, so one run of quad indices serves all of them
+    std::vector<uint16_t> indices(MaxBatchGlyphs * 6);
+    for (uint32_t i = 0; i < MaxBatchGlyphs; i++)
+    {
         indices[i * 6 + 0] = 0 + 4 * i;
         indices[i * 6 + 1] = 1 + 4 * i;
         indices[i * 6 + 2] = 2 + 4 * i;
         indices[i * 6 + 3] = 2 + 4 * i;
         indices[i * 6 + 4] = 3 + 4 * i;
         indices[i * 6 + 5] = 0 + 4 * i;
-
-        cursorOffset += character.xAdvance;
     }
-}
 
-uint32_t TextField::CreateTexture(const std::string& texturePath)
-{
-    uint32_t id;
-
-    stbi_set_flip_vertically_on_load(1);
-    unsigned char* m_LocalBuffer;
-    int m_Width, m_Height, m_BPP;
+    glGenBuffers(1, &m_VertexBufferID);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+    glBufferData(GL_ARRAY_BUFFER, StreamBufferGlyphs * 4 * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
 
-    m_LocalBuffer = stbi_load(m_Font.GetTexturesPath().c_str(), &m_Width, &m_Height, &m_BPP, 4);
+    glGenVertexArrays(1, &m_VertexArrayID);
+    glBindVertexArray(m_VertexArrayID);
 
-    glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_2D, id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenBuffers(1, &m_IndexBufferID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
 
-    if (m_LocalBuffer)
-        stbi_image_free(m_LocalBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, Position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, TexCoord));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const void*)offsetof(Vertex, Color));
 
-    return id;
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+TextRenderer::~TextRenderer()
+{
+    for (const Font* font : m_AcquiredFonts)
+        font->ReleaseTexture();
 
+    glDeleteBuffers(1, &m_VertexBufferID);
+    glDeleteBuffers(1, &m_IndexBufferID);
+    glDeleteVertexArrays(1, &m_VertexArrayID);
+}
 
-TextRenderer::TextRenderer(const glm::mat4& projectionMatrix)
-    : m_ProjectionMatrix(projectionMatrix), m_ShaderID(0), m_ProjectionMatrixUniformLocation(0), m_ModelMatrixUniformLocation(0)
+void TextRenderer::Submit(const TextField& textField)
 {
-    m_ShaderID = CreateShader(s_VertexShaderSource, s_FragmentShaderSource);
-    m_ProjectionMatrixUniformLocation = glGetUniformLocation(m_ShaderID, "u_ProjectionMatrix");
-    m_ModelMatrixUniformLocation = glGetUniformLocation(m_ShaderID, "u_ModelMatrix");
+    AddQuads(textField.GetFont(), textField.GetVertices(), textField.GetText().size(), textField.GetPosition(), textField.GetScale(), textField.GetColor());
 }
 
-TextRenderer::~TextRenderer()
+void TextRenderer::Submit(const Font& font, const std::string& text, const glm::vec2& position, float scale, const glm::vec4& color)
 {
-    glDeleteProgram(m_ShaderID);
+    m_LayoutVertices.resize(text.size() * 16);
+    LayoutText(font, text.data(), text.size(), 0, m_LayoutVertices.data());
+
+    AddQuads(font, m_LayoutVertices.data(), text.size(), position, scale, color);
 }
 
-void TextRenderer::RenderTextField(const TextField& textField)
+void TextRenderer::AcquireFont(const Font& font)
 {
-    glBindVertexArray(textField.GetVertexArrayID());
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, textField.GetIndexBufferID());
+    // Batched text only needs the texels, the atlas texture is created when the renderer first draws with the font itself
+    if (std::find(m_AcquiredFonts.begin(), m_AcquiredFonts.end(), &font) == m_AcquiredFonts.end())
+    {
+        font.AcquireTexture();
+        m_AcquiredFonts.push_back(&font);
 
-    glUseProgram(m_ShaderID);
-    glUniformMatrix4fv(m_ProjectionMatrixUniformLocation, 1, GL_FALSE, &m_ProjectionMatrix[0][0]);
-    glUniformMatrix4fv(m_ModelMatrixUniformLocation, 1, GL_FALSE, &textField.GetModelMatrix()[0][0]);
+        // Created behind the back of the state cache
+        m_State.Invalidate();
+    }
+}
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textField.GetTextureID());
+void TextRenderer::AddQuads(const Font& font, const float* vertices, uint32_t glyphCount, const glm::vec2& position, float scale, const glm::vec4& color)
+{
+    Batch* batch = nullptr;
 
-    glDrawElements(GL_TRIANGLES, textField.GetText().size() * 6, GL_UNSIGNED_INT, nullptr);
+    for (Batch& existing : m_Batches)
+    {
+        if (existing.AtlasFont == &font)
+        {
+            batch = &existing;
+            break;
+        }
+    }
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glUseProgram(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if (!batch)
+    {
+        m_Batches.push_back({ &font, {} });
+        batch = &m_Batches.back();
+    }
+
+    glm::u8vec4 packedColor = glm::u8vec4(glm::round(glm::clamp(color, 0.0f, 1.0f) * 255.0f));
+    uint32_t vertexColor;
+    std::memcpy(&vertexColor, &packedColor, sizeof(vertexColor));
+
+    for (uint32_t i = 0; i < glyphCount * 4; i++)
+    {
+        const float* corner = &vertices[i * 4];
+        batch->Vertices.push_back({ position + scale * glm::vec2(corner[0], corner[1]), glm::vec2(corner[2], corner[3]), vertexColor });
+    }
 }
 
-uint32_t TextRenderer::CreateShader(const std::string& vertexSource, const std::string& fragmentSource)
+void TextRenderer::Flush()
 {
-    uint32_t id = glCreateProgram();
+    PROFILE_GPU_SCOPE("TextRenderer::Flush");
+
+    m_State.BindVertexArray(m_VertexArrayID);
+
+    for (Batch& batch : m_Batches)
+    {
+        if (batch.Vertices.empty())
+            continue;
+
+        AcquireFont(*batch.AtlasFont);
+
+        if (batch.AtlasFont->IsDistanceField())
+        {
+            // The outline width is a distance in font pixels, the texels store it relative to the range of the font
+            m_State.UseProgram(m_DistanceFieldShaderID);
+            m_State.SetUniform(m_OutlineColorUniformLocation, m_OutlineColor);
+            m_State.SetUniform(m_OutlineWidthUniformLocation, std::min(m_OutlineWidth, batch.AtlasFont->GetDistanceRange()) / (2.0f * batch.AtlasFont->GetDistanceRange()));
+        }
+        else
+        {
+            m_State.UseProgram(m_ShaderID);
+        }
+
+        m_State.BindTexture(0, batch.AtlasFont->GetTextureID());
+
+        // Batches beyond the index buffer are drawn in pieces
+        for (uint32_t first = 0; first < batch.Vertices.size(); first += MaxBatchGlyphs * 4)
+        {
+            uint32_t vertexCount = std::min<uint32_t>(batch.Vertices.size() - first, MaxBatchGlyphs * 4);
 
-    uint32_t vs = glCreateShader(GL_VERTEX_SHADER);
-    uint32_t fs = glCreateShader(GL_FRAGMENT_SHADER);
+            // Orphaning hands the old storage back to the driver while the GPU may still read it, no sync needed
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_VertexBufferID);
+            if (m_StreamOffset + vertexCount > StreamBufferGlyphs * 4)
+            {
+                glBufferData(GL_COPY_WRITE_BUFFER, StreamBufferGlyphs * 4 * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+                m_StreamOffset = 0;
+            }
 
-    const char* src = vertexSource.c_str();
-    glShaderSource(vs, 1, &src, nullptr);
-    src = fragmentSource.c_str();
-    glShaderSource(fs, 1, &src, nullptr);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, m_StreamOffset * sizeof(Vertex), vertexCount * sizeof(Vertex), &batch.Vertices[first]);
+            glDrawElementsBaseVertex(GL_TRIANGLES, vertexCount / 4 * 6, GL_UNSIGNED_SHORT, nullptr, m_StreamOffset);
+            m_State.CountDrawCall();
 
-    glCompileShader(vs);
-    glCompileShader(fs);
+            m_StreamOffset += vertexCount;
+        }
+
+        // The capacity is kept for the next frame
+        batch.Vertices.clear();
+    }
+}
+
+void TextRenderer::Flush(BatchRenderer& batchRenderer, uint8_t layer)
+{
+    for (Batch& batch : m_Batches)
+    {
+        if (batch.Vertices.empty())
+            continue;
 
-    glAttachShader(id, vs);
-    glAttachShader(id, fs);
-    glLinkProgram(id);
-    glValidateProgram(id);
+        BatchRenderer::Texture texture = batchRenderer.GetFontTexture(*batch.AtlasFont);
 
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+        if (batch.AtlasFont->IsDistanceField())
+            batchRenderer.SetOutline(m_OutlineColor, std::min(m_OutlineWidth, batch.AtlasFont->GetDistanceRange()) / (2.0f * batch.AtlasFont->GetDistanceRange()));
 
-    return id;
+        // Corners 0 and 2 of a glyph are opposite, the batch rebuilds the other two from them
+        for (uint32_t i = 0; i < batch.Vertices.size(); i += 4)
+        {
+            const Vertex& topLeft = batch.Vertices[i];
+            const Vertex& bottomRight = batch.Vertices[i + 2];
+
+            batchRenderer.Submit(layer, topLeft.Position, bottomRight.Position, topLeft.Color, texture, topLeft.TexCoord, bottomRight.TexCoord);
+        }
+
+        batch.Vertices.clear();
+    }
 }
 
 
@@ -261,15 +606,20 @@ const std::string TextRenderer::s_VertexShaderSource =
     "\n"
     "layout(location = 0) in vec4 position;\n"
     "layout(location = 1) in vec2 texCoord;\n"
+    "layout(location = 2) in vec4 color;\n"
     "\n"
     "out vec2 v_TexCoord;\n"
-    "uniform mat4 u_ProjectionMatrix;\n"
-    "uniform mat4 u_ModelMatrix;\n"
+    "out vec4 v_Color;\n"
+    "layout(std140) uniform Projection\n"
+    "{\n"
+    "   mat4 u_ProjectionMatrix;\n"
+    "};\n"
     "\n"
     "void main()\n"
     "{\n"
-    "   gl_Position = u_ProjectionMatrix * u_ModelMatrix * position;\n"
+    "   gl_Position = u_ProjectionMatrix * position;\n"
     "   v_TexCoord = texCoord;\n"
+    "   v_Color = color;\n"
     "}\n";
 
 const std::string TextRenderer::s_FragmentShaderSource =
@@ -278,9 +628,35 @@ const std::string TextRenderer::s_FragmentShaderSource =
     "layout(location = 0) out vec4 color;\n"
     "\n"
     "in vec2 v_TexCoord;\n"
+    "in vec4 v_Color;\n"
     "uniform sampler2D u_Texture;\n"
     "\n"
     "void main()\n"
     "{\n"
-    "   color = texture(u_Texture, v_TexCoord);\n"
+    "   color = texture(u_Texture, v_TexCoord) * v_Color;\n"
+    "}\n";
+
+// Distance 0.5 is the outline, the edge is smoothed over one screen pixel whatever the scale
+const std::string TextRenderer::s_DistanceFieldFragmentShaderSource =
+    "#version 330 core\n"
+    "\n"
+    "layout(location = 0) out vec4 color;\n"
+    "\n"
+    "in vec2 v_TexCoord;\n"
+    "in vec4 v_Color;\n"
+    "uniform sampler2D u_Texture;\n"
+    "uniform vec4 u_OutlineColor;\n"
+    "uniform float u_OutlineWidth;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "   float distance = texture(u_Texture, v_TexCoord).a;\n"
+    "   float smoothing = 0.5 * fwidth(distance);\n"
+    "\n"
+    "   float fill = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);\n"
+    "   float outline = smoothstep(0.5 - u_OutlineWidth - smoothing, 0.5 - u_OutlineWidth + smoothing, distance);\n"
+    "\n"
+    "   vec4 outlineColor = u_OutlineWidth > 0.0 ? u_OutlineColor : v_Color;\n"
+    "   color = mix(outlineColor, v_Color, fill);\n"
+    "   color.a *= outline;\n"
     "}\n";
\ No newline at end of file
@@ -10,88 +10,238 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "stb_image.h"
 
+#include "BatchRenderer.h"
+#include "GLState.h"
+#include "MappedFile.h"
+#include "ShaderManager.h"
+
 class Font
 {
 public:
+    // Code points below this are looked up in a direct table, the few above it through a small hash table
+    static constexpr uint32_t DirectCharacterCount = 256;
+
+public:
+    Font();
     Font(const std::string& fontFilePath, const std::string& fontTextruresPath);
-    virtual ~Font() = default;
+    virtual ~Font();
+
+    // BMFont text file plus the atlas PNG. Loading only reads and decodes (no GL calls), so it can run on a loader thread
+    bool Load(const std::string& fontFilePath, const std::string& fontTextruresPath);
+    // Binary font written by FontBaker, mapped instead of parsed, the atlas texels are uploaded straight from the mapping
+    bool LoadBaked(const std::string& bakedFontPath);
 
 public:
+    // Metrics in pixels of the atlas, the texture coordinates are normalized when the font is loaded
     struct Character
     {
-        float charID;
-        float xCoord, yCoord;
-        float width, height;
-        float xOffset, yOffset;
-        float xAdvance;
+        uint32_t charID;
+        int32_t xCoord, yCoord;
+        int32_t width, height;
+        int32_t xOffset, yOffset;
+        int32_t xAdvance;
+        float u0, v0;           // top left corner
+        float u1, v1;           // bottom right corner
     };
 
-    const Character& GetCharacter(uint32_t charID) const;
+    const Character& GetCharacter(uint32_t charID) const
+    {
+        if (charID < DirectCharacterCount && m_DirectCharacters[charID] != NoCharacter)
+            return m_Characters[m_DirectCharacters[charID]];
+
+        return FindCharacter(charID);
+    }
+
     const std::string& GetTexturesPath() const { return m_TexturesPath; }
 
+    // The atlas texture is shared by every text renderer drawing with the font, it is created by the first
+    // AcquireTexture and deleted when the last reference is released
+    uint32_t AcquireTexture() const;
+    void ReleaseTexture() const;
+    // Creates the texture ahead of the first AcquireTexture, e.g. as soon as a background load finished
+    void UploadTexture() const;
+    uint32_t GetTextureID() const { return m_TextureID; }
+    // GPU memory of the atlas, 0 while no text renderer uses it
+    uint64_t GetTextureBytes() const { return m_TextureBytes; }
+
+    // Atlas texels, bottom row first, valid as long as the font is loaded
+    const uint8_t* GetTexels() const { return m_Texels; }
+    uint32_t GetTextureWidth() const { return m_TextureWidth; }
+    uint32_t GetTextureHeight() const { return m_TextureHeight; }
+    uint32_t GetTextureChannelCount() const { return m_TextureChannelCount; }
+
+    // Distance field atlases (baked with FontBaker --sdf) hold the distance to the outline instead of the coverage
+    bool IsDistanceField() const { return m_DistanceRange > 0.0f; }
+    // Distance in font pixels that maps to the full texel range on each side of the outline
+    float GetDistanceRange() const { return m_DistanceRange; }
+
 private:
+    static constexpr uint16_t NoCharacter = UINT16_MAX;
+
+    struct HashedCharacter
+    {
+        uint32_t CharID;
+        uint16_t Index;
+    };
+
     std::vector<Character> m_Characters;
+    uint16_t m_DirectCharacters[DirectCharacterCount];
+    std::vector<HashedCharacter> m_HashedCharacters;   // open addressing, the size is a power of two
     std::string m_TexturesPath;
 
+    // Baked fonts point into the mapping, the others at the decoded PNG
+    MappedFile m_BakedFile;
+    std::vector<uint8_t> m_DecodedTexels;
+    const uint8_t* m_Texels;
+    uint32_t m_TextureWidth;
+    uint32_t m_TextureHeight;
+    uint32_t m_TextureChannelCount;
+    float m_DistanceRange;
+
+    mutable uint32_t m_TextureID;
+    mutable uint32_t m_TextureReferenceCount;
+    mutable uint64_t m_TextureBytes;
+
 private:
     void ParseFondFile(const std::string& fontFilePath, std::vector<Character>& outCharacters);
+    void BuildLookup();
+    const Character& FindCharacter(uint32_t charID) const;
+    void CreateTexture() const;
+    static uint32_t HashCharID(uint32_t charID) { return charID * 2654435761u; }
 };
 
 
 
+// A label, its glyph quads are laid out once per SetText and copied into the text batch when it is submitted.
+// Storage for capacity characters is reserved up front, texts that fit never allocate and only the glyphs from the
+// first changed character on are laid out again. It holds no GL objects, the renderer drawing it owns the atlas
 class TextField
 {
 public:
-    TextField(const glm::vec2& position, float scale, const std::string& text, const Font& font);
-    ~TextField();
+    TextField(const glm::vec2& position, float scale, const std::string& text, const Font& font, const glm::vec4& color = glm::vec4(1.0f), uint32_t capacity = 0);
 
 public:
-    const glm::mat4& GetModelMatrix() const { return m_ModelMatrix; }
-
     const std::string& GetText() const { return m_Text; }
-    void SetText(const std::string& text);
+    void SetText(const std::string& text) { SetText(text.data(), text.size()); }
+    void SetText(const char* text, uint32_t length);
+    uint32_t GetCapacity() const { return m_Text.capacity(); }
 
-    uint32_t GetVertexBufferID() const { return m_VertexBufferID; }
-    uint32_t GetIndexBufferID() const { return m_IndexBufferID; }
-    uint32_t GetVertexArrayID() const { return m_VertexArrayID; }
-    uint32_t GetTextureID() const { return m_TextureID; }
+    const Font& GetFont() const { return m_Font; }
+    const glm::vec2& GetPosition() const { return m_Position; }
+    float GetScale() const { return m_Scale; }
+    const glm::vec4& GetColor() const { return m_Color; }
+    void SetColor(const glm::vec4& color) { m_Color = color; }
+
+    // 4 corners per character (x, y, u, v), in font pixels relative to the position
+    const float* GetVertices() const { return m_Vertices.data(); }
 
 private:
-    glm::mat4 m_ModelMatrix;
+    glm::vec2 m_Position;
+    float m_Scale;
+    glm::vec4 m_Color;
     std::string m_Text;
     const Font& m_Font;
 
-    uint32_t m_VertexBufferID;
-    uint32_t m_IndexBufferID;
-    uint32_t m_VertexArrayID;
-    uint32_t m_TextureID;
+    std::vector<float> m_Vertices;
+};
+
+
+
+// Counter for the HUD (lines, score, fps), the digits are formatted into a fixed buffer instead of a std::string and
+// an unchanged value costs nothing
+class NumericField
+{
+public:
+    static constexpr uint32_t MaxDigits = 20;       // UINT64_MAX
+
+public:
+    NumericField(const glm::vec2& position, float scale, uint64_t value, const Font& font, const glm::vec4& color = glm::vec4(1.0f));
+
+public:
+    uint64_t GetValue() const { return m_Value; }
+    void SetValue(uint64_t value);
+
+    const TextField& GetTextField() const { return m_TextField; }
+    void SetColor(const glm::vec4& color) { m_TextField.SetColor(color); }
 
 private:
-    void GenerateVerticesAndIndices(float* vertices, uint32_t* indices);
-    uint32_t CreateTexture(const std::string& texturePath);
+    TextField m_TextField;
+    uint64_t m_Value;
 };
 
 
 
+// Collects the glyph quads of every string submitted during a frame and draws them with one draw call per atlas.
+// The quads are streamed through a vertex buffer used as a ring (orphaned when it wraps), the index buffer is static
+// and shared by every batch
 class TextRenderer
 {
 public:
-    TextRenderer(const glm::mat4& projectionMatrix);
+    // 4 vertices per glyph keep every batch addressable with 16 bit indices
+    static constexpr uint32_t MaxBatchGlyphs = 2048;
+    static constexpr uint32_t StreamBufferGlyphs = MaxBatchGlyphs * 4;
+
+public:
+    // Adds the text programs to the shader manager batch, it has to be finished before the renderer is created
+    static void LoadShaders(ShaderManager& shaderManager);
+
+    TextRenderer(GLState& state, const ShaderManager& shaderManager);
     ~TextRenderer();
 
 public:
-    void RenderTextField(const TextField& textField);
+    void Submit(const TextField& textField);
+    void Submit(const NumericField& numericField) { Submit(numericField.GetTextField()); }
+    // Text that changes every frame (counters, debug overlays) without the need for a TextField
+    void Submit(const Font& font, const std::string& text, const glm::vec2& position, float scale, const glm::vec4& color);
+
+    // Draws everything submitted since the last flush
+    void Flush();
+    // Hands everything submitted since the last flush to the 2D batch instead, as quads of the given layer. The atlases
+    // are copied into the batch texture arrays and the outline becomes the outline of the batch
+    void Flush(BatchRenderer& batchRenderer, uint8_t layer);
+
+    // Outline drawn around the glyphs of distance field fonts, width in font pixels (at most the distance range),
+    // 0 disables it. Bitmap fonts ignore it
+    void SetOutline(const glm::vec4& color, float width) { m_OutlineColor = color; m_OutlineWidth = width; }
 
 private:
-    glm::mat4 m_ProjectionMatrix;
+    struct Vertex
+    {
+        glm::vec2 Position;
+        glm::vec2 TexCoord;
+        uint32_t Color;         // RGBA8
+    };
+
+    struct Batch
+    {
+        const Font* AtlasFont;
+        std::vector<Vertex> Vertices;
+    };
+
+    GLState& m_State;
 
     uint32_t m_ShaderID;
-    int m_ProjectionMatrixUniformLocation;
-    int m_ModelMatrixUniformLocation;
+    uint32_t m_DistanceFieldShaderID;
+    int m_OutlineColorUniformLocation;
+    int m_OutlineWidthUniformLocation;
+
+    glm::vec4 m_OutlineColor;
+    float m_OutlineWidth;
+
+    uint32_t m_VertexArrayID;
+    uint32_t m_VertexBufferID;
+    uint32_t m_IndexBufferID;
+    uint32_t m_StreamOffset;        // in vertices
+
+    std::vector<Batch> m_Batches;
+    std::vector<const Font*> m_AcquiredFonts;
+    std::vector<float> m_LayoutVertices;
 
     static const std::string s_VertexShaderSource;
     static const std::string s_FragmentShaderSource;
+    static const std::string s_DistanceFieldFragmentShaderSource;
 
 private:
-    uint32_t CreateShader(const std::string& vertexSource, const std::string& fragmentSource);
+    void AcquireFont(const Font& font);
+    void AddQuads(const Font& font, const float* vertices, uint32_t glyphCount, const glm::vec2& position, float scale, const glm::vec4& color);
 };
\ No newline at end of file
@@ -0,0 +1,418 @@
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <bitset>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "Core/BatchRunner.h"
+#include "Core/Board.h"
+#include "Core/Bot.h"
+#include "Core/Evaluator.h"
+#include "Core/Game.h"
+#include "Core/Piece.h"
+#include "Core/Random.h"
+#include "Core/Tetromino.h"
+
+// Every heap allocation made by the process, the game core is expected not to allocate at all while playing
+static std::atomic<uint64_t> s_AllocationCount(0);
+
+void* operator new(size_t size)
+{
+    s_AllocationCount++;
+
+    if (void* pointer = std::malloc(size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+class Timer
+{
+public:
+    Timer()
+        : m_StartTimepoint(std::chrono::high_resolution_clock::now())
+    {}
+
+    double GetSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - m_StartTimepoint).count();
+    }
+
+private:
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_StartTimepoint;
+};
+
+struct Result
+{
+    uint64_t Pieces = 0;
+    uint64_t Lines = 0;
+    uint64_t Allocations = 0;
+    double Seconds = 0.0;
+};
+
+static void PrintResult(const char* scenario, const Result& result)
+{
+    std::cout << "bench scenario=" << scenario
+              << " pieces=" << result.Pieces
+              << " lines=" << result.Lines
+              << " seconds=" << result.Seconds
+              << " pieces_per_sec=" << result.Pieces / result.Seconds
+              << " lines_per_sec=" << result.Lines / result.Seconds
+              << " allocations=" << result.Allocations << std::endl;
+}
+
+// Fixed script: every O piece is rotated through all of its states, slid against the left wall, moved to its
+// column and dropped, 5 pieces fill two rows so every 5th piece clears two lines
+static Result RunScripted(uint64_t pieceCount)
+{
+    Board board;
+    Result result;
+
+    uint64_t allocations = s_AllocationCount;
+    Timer timer;
+
+    for (uint64_t i = 0; i < pieceCount; i++)
+    {
+        Piece piece(TetrominoType::O);
+
+        if (!piece.Fits(board))
+            board.Reset();
+
+        for (uint32_t rotation = 0; rotation < 4; rotation++)
+            piece.Rotate(board);
+
+        while (piece.MoveLeft(board));
+
+        for (uint32_t column = 0; column < (i % 5) * 2; column++)
+            piece.MoveRight(board);
+
+        while (piece.Move(board));
+
+        piece.Lock(board);
+        result.Lines += std::bitset<32>(board.ClearLines()).count();
+        result.Pieces++;
+    }
+
+    result.Seconds = timer.GetSeconds();
+    result.Allocations = s_AllocationCount - allocations;
+    return result;
+}
+
+// Full games through Game::Tick with random inputs, the soft drop is held so that pieces land quickly
+static Result RunRandom(uint64_t pieceCount, uint64_t seed)
+{
+    Game game(seed);
+    Random random(seed);
+    Result result;
+
+    uint64_t allocations = s_AllocationCount;
+    Timer timer;
+
+    while (result.Pieces < pieceCount)
+    {
+        uint8_t input = Game::InputSoftDrop;
+
+        if (random.NextBelow(4) == 0)
+            input |= 1 << random.NextBelow(4);
+
+        uint32_t pieces = game.GetPieceCount();
+        uint32_t lines = game.GetLines();
+
+        game.Tick(input);
+
+        result.Pieces += game.GetPieceCount() - pieces;
+        result.Lines += game.GetLines() - lines;
+
+        if (game.IsGameOver())
+            game.Reset(random.Next());
+    }
+
+    result.Seconds = timer.GetSeconds();
+    result.Allocations = s_AllocationCount - allocations;
+    return result;
+}
+
+static void RunCollision(uint64_t checkCount, uint64_t seed)
+{
+    Board board;
+    Random random(seed);
+
+    // Half filled board so that the checks hit both free and blocked positions
+    for (int row = Board::Height / 2; row < Board::Height; row++)
+    {
+        uint16_t cells = (uint16_t)(random.Next() & 0x3FF);
+
+        // Place keeps the cells and the hash in step for 4 wide masks only, the row goes in 4 columns at a time
+        for (int x = 0; x < Board::Width; x += 4)
+        {
+            PieceMask mask = { { (uint16_t)((cells >> x) & 0xF), 0, 0, 0 } };
+            board.Place(mask, x, row, 1);
+        }
+    }
+
+    // Positions are generated up front so that the loop only measures Board::Collides
+    const uint32_t positionCount = 1024;
+    int positions[positionCount][3];
+
+    for (uint32_t i = 0; i < positionCount; i++)
+    {
+        positions[i][0] = random.NextBelow(Tetromino::Count * 4);
+        positions[i][1] = (int)random.NextBelow(Board::Width + 2) - 2;
+        positions[i][2] = (int)random.NextBelow(Board::Height);
+    }
+
+    uint64_t collisions = 0;
+    Timer timer;
+
+    for (uint64_t i = 0; i < checkCount; i++)
+    {
+        const int* position = positions[i & (positionCount - 1)];
+        const PieceMask& mask = Tetromino::GetMask(position[0] / 4, position[0]);
+
+        collisions += board.Collides(mask, position[1], position[2]);
+    }
+
+    double seconds = timer.GetSeconds();
+
+    std::cout << "bench scenario=collision checks=" << checkCount
+              << " collisions=" << collisions
+              << " seconds=" << seconds
+              << " ns_per_check=" << seconds * 1e9 / checkCount << std::endl;
+}
+
+// Board feature evaluation with every kernel the CPU supports, on half filled random boards
+static void RunEvaluate(uint64_t boardCount, uint64_t seed)
+{
+    Random random(seed);
+
+    const uint32_t batchCount = 64;
+    static BoardBatch batches[batchCount];
+
+    for (uint32_t i = 0; i < batchCount; i++)
+    {
+        for (int row = 0; row < Board::Height; row++)
+        {
+            for (uint32_t lane = 0; lane < BoardBatch::Size; lane++)
+            {
+                uint16_t cells = row < Board::Height / 2 ? 0 : (uint16_t)(random.Next() << Board::Padding);
+                batches[i].Rows[row][lane] = Board::EmptyRow | cells;
+            }
+        }
+    }
+
+    const FeatureKernel kernels[] = { FeatureKernel::Scalar, FeatureKernel::SSE42, FeatureKernel::AVX2 };
+
+    for (FeatureKernel kernel : kernels)
+    {
+        if (!IsFeatureKernelSupported(kernel))
+            continue;
+
+        BoardFeatures features[BoardBatch::Size];
+        uint64_t holes = 0;
+        uint64_t calls = boardCount / BoardBatch::Size;
+        Timer timer;
+
+        for (uint64_t i = 0; i < calls; i++)
+        {
+            ComputeFeatures(batches[i % batchCount], BoardBatch::Size, features, kernel);
+            holes += features[i % BoardBatch::Size].Holes;
+        }
+
+        double seconds = timer.GetSeconds();
+
+        std::cout << "bench scenario=evaluate kernel=" << GetFeatureKernelName(kernel)
+                  << " boards=" << calls * BoardBatch::Size
+                  << " holes=" << holes
+                  << " seconds=" << seconds
+                  << " ns_per_board=" << seconds * 1e9 / (calls * BoardBatch::Size) << std::endl;
+    }
+}
+
+// Full games played by the placement search bot through Game::Tick, capped at maxPieces per game
+static void RunBot(uint64_t gameCount, uint32_t maxPieces, uint64_t seed)
+{
+    Bot bot;
+    Result result;
+
+    uint64_t allocations = s_AllocationCount;
+    Timer timer;
+
+    for (uint64_t i = 0; i < gameCount; i++)
+    {
+        Game game(seed + i);
+        bot.Reset();
+
+        while (!game.IsGameOver() && game.GetPieceCount() < maxPieces)
+            game.Tick(bot.GetInput(game));
+
+        result.Pieces += game.GetPieceCount();
+        result.Lines += game.GetLines();
+    }
+
+    result.Seconds = timer.GetSeconds();
+    result.Allocations = s_AllocationCount - allocations;
+    PrintResult("bot", result);
+
+    // Search cost alone, every piece type on a board left behind by 100 bot moves
+    Game game(seed);
+    while (!game.IsGameOver() && game.GetPieceCount() < 100)
+        game.Tick(bot.GetInput(game));
+
+    Bot::Placement placements[Bot::MaxPlacements];
+    const uint32_t searchCount = 10000;
+    uint64_t placementCount = 0;
+    Timer searchTimer;
+
+    for (uint32_t i = 0; i < searchCount; i++)
+    {
+        Piece piece((TetrominoType)(i % Tetromino::Count));
+        uint32_t count = bot.FindPlacements(game.GetBoard(), piece, placements);
+        bot.ChoosePlacement(game.GetBoard(), piece.GetType(), placements, count);
+        placementCount += count;
+    }
+
+    double seconds = searchTimer.GetSeconds();
+
+    std::cout << "bench scenario=search searches=" << searchCount
+              << " placements_per_search=" << (double)placementCount / searchCount
+              << " seconds=" << seconds
+              << " us_per_search=" << seconds * 1e6 / searchCount << std::endl;
+}
+
+// Independent bot games spread over threadCount workers, with scaling set the same batch is also played on
+// 1, 2, 4, ... workers to show how close the throughput gets to linear
+static void RunBatch(uint64_t gameCount, uint32_t maxPieces, uint64_t seed, uint32_t threadCount, bool scaling, size_t cacheBytes)
+{
+    std::vector<uint32_t> threadCounts;
+
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    if (scaling)
+    {
+        for (uint32_t count = 1; count < threadCount; count *= 2)
+            threadCounts.push_back(count);
+    }
+
+    threadCounts.push_back(threadCount);
+
+    double baseGamesPerSecond = 0.0;
+
+    for (uint32_t count : threadCounts)
+    {
+        BatchRunner runner(count, cacheBytes);
+
+        uint64_t allocations = s_AllocationCount;
+        const BatchSummary& summary = runner.Run(gameCount, seed, maxPieces);
+        allocations = s_AllocationCount - allocations;
+
+        if (count == 1)
+            baseGamesPerSecond = summary.GamesPerSecond;
+
+        std::cout << "bench scenario=batch threads=" << count
+                  << " games=" << summary.Games
+                  << " pieces=" << summary.Pieces
+                  << " lines=" << summary.Lines
+                  << " mean_lines=" << summary.MeanLines
+                  << " mean_score=" << summary.MeanScore
+                  << " topped_out=" << summary.ToppedOut
+                  << " mean_ms_per_game=" << summary.MeanMilliseconds
+                  << " max_ms_per_game=" << summary.MaxMilliseconds
+                  << " seconds=" << summary.Seconds
+                  << " games_per_sec=" << summary.GamesPerSecond
+                  << " steals=" << summary.Steals
+                  << " allocations=" << allocations;
+
+        if (cacheBytes > 0)
+        {
+            std::cout << " cache_mb=" << runner.GetTranspositionTable()->GetSizeBytes() / (1024.0 * 1024.0)
+                      << " cache_hits=" << summary.CacheHits
+                      << " cache_misses=" << summary.CacheMisses
+                      << " cache_evictions=" << summary.CacheEvictions;
+        }
+
+        if (baseGamesPerSecond > 0.0)
+            std::cout << " speedup=" << summary.GamesPerSecond / baseGamesPerSecond;
+
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t pieceCount = 1000000;
+    // Per game limit of the bot runs, --pieces sizes the other runs
+    uint64_t maxPieces = 1000;
+    uint64_t seed = 1;
+    uint64_t gameCount = 0;
+    // 0 is one thread per hardware thread, far above any core count is a typo rather than a benchmark
+    const int64_t MaxThreadCount = 1024;
+    int64_t threadCount = 0;
+    bool scaling = false;
+    uint64_t cacheMegabytes = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+
+        if (argument == "--pieces" && i + 1 < argc)
+            pieceCount = std::stoull(argv[++i]);
+        else if (argument == "--max-pieces" && i + 1 < argc)
+            maxPieces = std::stoull(argv[++i]);
+        else if (argument == "--seed" && i + 1 < argc)
+            seed = std::stoull(argv[++i]);
+        else if (argument == "--games" && i + 1 < argc)
+            gameCount = std::stoull(argv[++i]);
+        else if (argument == "--threads" && i + 1 < argc)
+            threadCount = std::stoll(argv[++i]);
+        else if (argument == "--scaling")
+            scaling = true;
+        else if (argument == "--cache-mb" && i + 1 < argc)
+            cacheMegabytes = std::stoull(argv[++i]);
+    }
+
+    if (maxPieces == 0 || maxPieces > UINT32_MAX)
+    {
+        std::cout << "--max-pieces has to be between 1 and " << UINT32_MAX << std::endl;
+        return 1;
+    }
+
+    if (threadCount < 0 || threadCount > MaxThreadCount)
+    {
+        std::cout << "--threads has to be between 0 (one per hardware thread) and " << MaxThreadCount << std::endl;
+        return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    // Batch only mode, used for bot tuning runs
+    if (gameCount > 0)
+    {
+        RunBatch(gameCount, maxPieces, seed, (uint32_t)threadCount, scaling, cacheMegabytes * 1024 * 1024);
+        return 0;
+    }
+
+    PrintResult("scripted", RunScripted(pieceCount));
+    PrintResult("random", RunRandom(pieceCount / 10, seed));
+    RunCollision(pieceCount * 100, seed);
+    RunEvaluate(pieceCount * 10, seed);
+    RunBot(10, maxPieces, seed);
+
+    return 0;
+}